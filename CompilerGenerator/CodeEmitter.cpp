@@ -2,14 +2,18 @@
 
 #include "CodeEmitter.h"
 #include "Templates.h"
+#include "TemplateRenderer.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <cstdint>
+#include <cstdio>
 
 const std::string LEXER_FILENAME = "lexer";
 const std::string PARSER_FILENAME = "parser";
+const std::string BATCH_FILENAME = "batch_main";
 
 // 辅助：去除首尾空格
 static std::string trim(const std::string& str) {
@@ -26,34 +30,418 @@ static bool is_space(char c) {
     return std::isspace(static_cast<unsigned char>(c));
 }
 
-static std::string replaceAll(std::string str, const std::string& from, const std::string& to) {
-    size_t start_pos = 0;
-    while ((start_pos = str.find(from, start_pos)) != std::string::npos) {
-        str.replace(start_pos, from.length(), to);
-        start_pos += to.length();
+// 辅助：解析 %type 之后的部分，例如 " <trueList, falseList> BoolExpr BoolTerm"
+static bool parseTypeDeclaration(const std::string& decl, SymbolTypeMap& outTypes) {
+    size_t open = decl.find('<');
+    size_t close = decl.find('>', open == std::string::npos ? 0 : open);
+    if (open == std::string::npos || close == std::string::npos) {
+        return false;
+    }
+
+    // 字段列表，逗号或空白分隔；允许为空 (%type <> X 表示不携带任何属性)
+    std::vector<std::string> fields;
+    std::string fieldList = decl.substr(open + 1, close - open - 1);
+    std::replace(fieldList.begin(), fieldList.end(), ',', ' ');
+    std::stringstream ssFields(fieldList);
+    std::string field;
+    while (ssFields >> field) {
+        fields.push_back(field);
     }
-    return str;
+
+    std::stringstream ssSymbols(decl.substr(close + 1));
+    std::string symbol;
+    bool any = false;
+    while (ssSymbols >> symbol) {
+        outTypes[symbol] = fields;
+        any = true;
+    }
+    return any;
 }
 
-static bool generateFile(const std::string& filepath, const std::string& content) {
-	std::ofstream file(filepath);
+// SemanticValue 中可由 %type 选用的字段 (需与 TEMPLATE_PARSER_H 中的定义保持一致)
+// usesArena: 该字段需要用 Arena 构造
+struct SemanticField {
+    const char* name;
+    const char* declaration;
+    bool usesArena;
+};
+
+static const SemanticField SEMANTIC_FIELDS[] = {
+    { "text",      "ArenaString text;",     true },
+    { "line",      "int line = 0;",         false },
+    { "code",      "ArenaString code;",     true },
+    { "var",       "Operand var;",          false },
+    { "trueList",  "PatchList trueList;",   false },
+    { "falseList", "PatchList falseList;",  false },
+    { "nextList",  "PatchList nextList;",   false },
+    { "quad",      "int quad = 0;",         false },
+    { "val",       "int val = 0;",          false },
+};
+
+// 辅助：按字段集合生成规范的类型名，例如 {falseList, trueList} -> Value_trueList_falseList
+// 空集合对应 std::monostate；出现未知字段时返回 false
+static bool valueTypeName(const std::vector<std::string>& fields, std::string& outName) {
+    for (const auto& field : fields) {
+        bool known = false;
+        for (const auto& f : SEMANTIC_FIELDS) {
+            if (field == f.name) known = true;
+        }
+        if (!known) return false;
+    }
+    if (fields.empty()) {
+        outName = "std::monostate";
+        return true;
+    }
+
+    outName = "Value";
+    for (const auto& f : SEMANTIC_FIELDS) {
+        if (std::find(fields.begin(), fields.end(), f.name) != fields.end()) {
+            outName += std::string("_") + f.name;
+        }
+    }
+    return true;
+}
 
-    if (!file.is_open()) {
+// 辅助：输出一个精简语义值结构体的定义
+static void emitValueStruct(OutputSink& out, const std::string& typeName, const std::vector<std::string>& fields) {
+    std::string initList;
+    out << "struct " << typeName << " {\n";
+    for (const auto& f : SEMANTIC_FIELDS) {
+        if (std::find(fields.begin(), fields.end(), f.name) != fields.end()) {
+            out << "    " << f.declaration << "\n";
+            if (f.usesArena) {
+                initList += (initList.empty() ? " : " : ", ") + std::string(f.name) + "(arena)";
+            }
+        }
+    }
+    // 统一的构造方式：所有语义值都由 Arena 构造 (不需要 Arena 的字段忽略该参数)
+    out << "\n    explicit " << typeName << "(std::pmr::memory_resource*" << (initList.empty() ? "" : " arena") << ")"
+        << initList << " {}\n";
+    out << "};\n\n";
+}
+
+// 辅助：替换语义动作中的 $$ 与 $n，记录用到了哪些右部符号
+// 逐字符扫描，避免 $1 误替换 $10 的前缀；超出右部长度的 $n 原样保留
+static std::string substituteActionRefs(const std::string& action, int rhsCount, std::set<int>& usedRefs) {
+    std::string result;
+    size_t i = 0;
+    while (i < action.size()) {
+        if (action[i] == '$' && i + 1 < action.size() && action[i + 1] == '$') {
+            result += "res";
+            i += 2;
+            continue;
+        }
+        if (action[i] == '$' && i + 1 < action.size() && std::isdigit(static_cast<unsigned char>(action[i + 1]))) {
+            size_t j = i + 1;
+            while (j < action.size() && std::isdigit(static_cast<unsigned char>(action[j]))) j++;
+            int index = std::stoi(action.substr(i + 1, j - i - 1));
+            if (index >= 1 && index <= rhsCount) {
+                result += "v" + std::to_string(index);
+                usedRefs.insert(index);
+            }
+            else {
+                result += action.substr(i, j - i);
+            }
+            i = j;
+            continue;
+        }
+        result += action[i++];
+    }
+    return result;
+}
+
+// 辅助：语义动作是否为空 (没有动作，或只有一对空的大括号)
+static bool isEmptyAction(const std::string& action) {
+    std::string body = trim(action);
+    if (body.size() >= 2 && body.front() == '{' && body.back() == '}') {
+        body = trim(body.substr(1, body.size() - 2));
+    }
+    return std::all_of(body.begin(), body.end(), is_space);
+}
+
+// 辅助：产生式的可读形式，例如 "E -> E + T"
+static std::string ruleDisplay(const ProductionRule& rule) {
+    std::string disp = rule.lhs + " -> ";
+    if (rule.rhs.empty()) {
+        disp += "ε"; // 处理空产生式
+    }
+    else {
+        for (size_t i = 0; i < rule.rhs.size(); ++i) {
+            disp += rule.rhs[i] + (i == rule.rhs.size() - 1 ? "" : " ");
+        }
+    }
+    return disp;
+}
+
+// 辅助：转义后可放入生成代码的字符串字面量 (同时也是合法的 JSON 字符串内容)
+static std::string escapeString(const std::string& str) {
+    std::string out;
+    for (char c : str) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+// 辅助：生成代码中与 unsigned char 比较的字符常量；可打印字符写成字符字面量，其余写成数值
+static std::string charLiteral(unsigned char c) {
+    if (c == '\n') return "'\\n'";
+    if (c == '\t') return "'\\t'";
+    if (c == '\r') return "'\\r'";
+    if (c == '\'' || c == '\\') return std::string("'\\") + (char)c + "'";
+    if (c >= 32 && c <= 126) return std::string("'") + (char)c + "'";
+    return std::to_string((int)c);
+}
+
+// 辅助：分析表中出现的状态数 (最大状态号 + 1)
+static int countStates(const ActionTable& actionTbl, const GotoTable& gotoTbl) {
+    int maxState = 0;
+    for (const auto& entry : actionTbl) {
+        maxState = std::max(maxState, entry.first.first);
+        if (entry.second.type == ACTION_SHIFT) maxState = std::max(maxState, entry.second.target);
+    }
+    for (const auto& entry : gotoTbl) {
+        maxState = std::max(maxState, std::max(entry.first.first, entry.second));
+    }
+    return maxState + 1;
+}
+
+// 辅助：输出一个整型数组定义，每行 16 个元素
+static void emitIntArray(OutputSink& os, const char* elemType, const char* name, const std::vector<int>& values) {
+    os << "const " << elemType << " " << name << "[] = {";
+    for (size_t i = 0; i < values.size(); ++i) {
+        os << (i % 16 == 0 ? "\n    " : " ") << values[i] << ",";
+    }
+    os << "\n};\n";
+}
+
+// 辅助：关键字哈希 (带种子的 FNV-1a)，必须与 TEMPLATE_KEYWORD_MATCH 中的 keywordHash 一致
+static uint32_t keywordHash(const std::string& text, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for (char c : text) {
+        h ^= (unsigned char)c;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// 关键字的最小完美哈希 (hash-and-displace)
+// 第一次哈希把关键字分进桶 (平均每桶 4 个)，从大桶开始给每个桶找一个位移 d，
+// 使桶内关键字以 d 为种子的第二次哈希落在互不相同的空槽里；找不到就多加一个槽重来
+struct KeywordHashTable {
+    uint32_t bucketCount;
+    std::vector<uint32_t> displacement; // 每个桶
+    std::vector<int> slots;             // 槽 -> 关键字下标，空槽为 -1
+};
+
+static KeywordHashTable buildKeywordHash(const std::vector<KeywordDefinition>& keywords) {
+    const uint32_t MAX_DISPLACEMENT = 1u << 16;
+    KeywordHashTable table;
+    table.bucketCount = (uint32_t)std::max<size_t>((keywords.size() + 3) / 4, 1);
+    std::vector<std::vector<int>> buckets(table.bucketCount);
+    for (size_t i = 0; i < keywords.size(); ++i) {
+        buckets[keywordHash(keywords[i].text, 0) % table.bucketCount].push_back((int)i);
+    }
+    std::vector<uint32_t> order(table.bucketCount);
+    for (uint32_t b = 0; b < table.bucketCount; ++b) order[b] = b;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    for (size_t slotCount = std::max<size_t>(keywords.size(), 1); ; ++slotCount) {
+        table.displacement.assign(table.bucketCount, 0);
+        table.slots.assign(slotCount, -1);
+        bool placedAll = true;
+        std::vector<uint32_t> targets;
+        for (uint32_t b : order) {
+            if (buckets[b].empty()) break;
+            bool placed = false;
+            for (uint32_t d = 0; d < MAX_DISPLACEMENT && !placed; ++d) {
+                targets.clear();
+                placed = true;
+                for (int k : buckets[b]) {
+                    uint32_t slot = keywordHash(keywords[k].text, d) % (uint32_t)slotCount;
+                    if (table.slots[slot] >= 0 || std::find(targets.begin(), targets.end(), slot) != targets.end()) {
+                        placed = false;
+                        break;
+                    }
+                    targets.push_back(slot);
+                }
+                if (placed) {
+                    table.displacement[b] = d;
+                    for (size_t i = 0; i < targets.size(); ++i) table.slots[targets[i]] = buckets[b][i];
+                }
+            }
+            if (!placed) {
+                placedAll = false;
+                break;
+            }
+        }
+        if (placedAll) return table;
+    }
+}
+
+// 辅助：输出关键字完美哈希的数据与查找函数 matchKeyword (没有关键字时查找总是返回 fallback)
+static void emitKeywordTables(OutputSink& os, const std::vector<KeywordDefinition>& keywords) {
+    KeywordHashTable table = buildKeywordHash(keywords);
+    size_t minLength = 1, maxLength = 0;
+    for (size_t i = 0; i < keywords.size(); ++i) {
+        minLength = i == 0 ? keywords[i].text.size() : std::min(minLength, keywords[i].text.size());
+        maxLength = std::max(maxLength, keywords[i].text.size());
+    }
+
+    os << "\n// ==========================================\n";
+    os << "//  关键字完美哈希 (自动生成)\n";
+    os << "//  关键字不在 DFA 中，覆盖它的规则识别出的词素经 matchKeyword 改判\n";
+    os << "// ==========================================\n";
+    os << "namespace {\n\n";
+    os << "const uint32_t KEYWORD_BUCKET_COUNT = " << table.bucketCount << ";\n";
+    os << "const uint32_t KEYWORD_SLOT_COUNT = " << table.slots.size() << ";\n";
+    os << "const size_t KEYWORD_MIN_LENGTH = " << minLength << ";\n";
+    os << "const size_t KEYWORD_MAX_LENGTH = " << maxLength << ";\n";
+    std::vector<int> displacement(table.displacement.begin(), table.displacement.end());
+    emitIntArray(os, "uint32_t", "KEYWORD_DISPLACEMENT", displacement);
+    os << "const char* const KEYWORD_TEXT[] = {";
+    for (size_t i = 0; i < table.slots.size(); ++i) {
+        int k = table.slots[i];
+        os << (i % 8 == 0 ? "\n    " : " ") << "\"" << (k >= 0 ? escapeString(keywords[k].text) : "") << "\",";
+    }
+    os << "\n};\n";
+    os << "const char* const KEYWORD_TOKEN[] = {";
+    for (size_t i = 0; i < table.slots.size(); ++i) {
+        int k = table.slots[i];
+        os << (i % 8 == 0 ? "\n    " : " ") << "\"" << (k >= 0 ? escapeString(keywords[k].name) : "") << "\",";
+    }
+    os << "\n};\n";
+    os << TEMPLATE_KEYWORD_MATCH;
+}
+
+// 辅助：生成压缩的 GOTO 表
+// 对每个非终结符，出现最多的目标状态作为默认值 (GOTO_DEFAULT)，其余 (状态, 目标) 作为例外；
+// 例外按首次适配 (first-fit) 找一个基址 GOTO_BASE，使其所有状态错位后落在 GOTO_NEXT 的空槽中，
+// 查表时用 GOTO_CHECK 确认槽位确实属于当前状态，否则回退到默认值
+static void emitGotoTables(OutputSink& os, const GotoTable& gotoTbl,
+    const std::map<std::string, int>& nonterminalId,
+    const std::vector<std::string>& nonterminalNames,
+    int stateCount)
+{
+    size_t ntCount = nonterminalNames.size();
+    std::vector<std::vector<std::pair<int, int>>> entries(ntCount); // 非终结符 -> (状态, 目标)
+    for (const auto& entry : gotoTbl) {
+        auto it = nonterminalId.find(entry.first.second);
+        if (it == nonterminalId.end()) continue;
+        entries[it->second].push_back(std::make_pair(entry.first.first, entry.second));
+    }
+
+    // 1. 默认值：出现次数最多的目标状态
+    std::vector<int> defaults(ntCount, -1);
+    std::vector<std::vector<std::pair<int, int>>> exceptionsOf(ntCount);
+    for (size_t nt = 0; nt < ntCount; ++nt) {
+        std::map<int, int> frequency;
+        for (const auto& e : entries[nt]) frequency[e.second]++;
+        int bestCount = 0;
+        for (const auto& f : frequency) {
+            if (f.second > bestCount) {
+                bestCount = f.second;
+                defaults[nt] = f.first;
+            }
+        }
+        for (const auto& e : entries[nt]) {
+            if (e.second != defaults[nt]) exceptionsOf[nt].push_back(e);
+        }
+    }
+
+    // 例外多的先放，表更紧凑
+    std::vector<size_t> order(ntCount);
+    for (size_t nt = 0; nt < ntCount; ++nt) order[nt] = nt;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return exceptionsOf[a].size() > exceptionsOf[b].size();
+    });
+
+    std::vector<int> bases(ntCount, -stateCount); // 无例外时基址使下标恒为负，直接取默认值
+    std::vector<int> next, check;
+    std::set<int> usedBases;
+
+    for (size_t nt : order) {
+        const auto& exceptions = exceptionsOf[nt];
+        if (exceptions.empty()) continue;
+
+        // 2. 首次适配：基址互不相同，保证 GOTO_CHECK 不会误命中其他非终结符的槽位
+        int base = -exceptions.front().first;
+        while (true) {
+            bool fits = usedBases.count(base) == 0;
+            for (size_t i = 0; fits && i < exceptions.size(); ++i) {
+                size_t slot = (size_t)(base + exceptions[i].first);
+                if (slot < check.size() && check[slot] != -1) fits = false;
+            }
+            if (fits) break;
+            base++;
+        }
+
+        usedBases.insert(base);
+        bases[nt] = base;
+        for (const auto& e : exceptions) {
+            size_t slot = (size_t)(base + e.first);
+            if (slot >= check.size()) {
+                check.resize(slot + 1, -1);
+                next.resize(slot + 1, -1);
+            }
+            check[slot] = e.first;
+            next[slot] = e.second;
+        }
+    }
+
+    if (check.empty()) {
+        check.push_back(-1);
+        next.push_back(-1);
+    }
+
+    os << "// 非终结符编号\n";
+    for (size_t nt = 0; nt < ntCount; ++nt) {
+        os << "//   " << nt << ": " << nonterminalNames[nt] << "\n";
+    }
+    os << "const int PARSER_GOTO_TABLE_SIZE = " << check.size() << ";\n";
+    emitIntArray(os, "ParserTableEntry", "PARSER_GOTO_DEFAULT", defaults);
+    emitIntArray(os, "int", "PARSER_GOTO_BASE", bases);
+    emitIntArray(os, "ParserTableEntry", "PARSER_GOTO_CHECK", check);
+    emitIntArray(os, "ParserTableEntry", "PARSER_GOTO_NEXT", next);
+}
+
+// 辅助：每个模板只切分一次 (按模板字符串的地址缓存)
+static const TemplateRenderer& compiledTemplate(const std::string& text) {
+    static std::map<const std::string*, TemplateRenderer> cache;
+    auto it = cache.find(&text);
+    if (it == cache.end()) {
+        it = cache.emplace(&text, TemplateRenderer(text)).first;
+    }
+    return it->second;
+}
+
+// 辅助：渲染模板，生成的代码段直接流式写入文件
+// emittedBytes 累加写出的字节数
+static bool generateFile(const std::string& filepath, const std::string& templateText,
+    const TemplateRenderer::SectionMap& sections, size_t& emittedBytes) {
+    OutputSink file(filepath);
+
+    if (!file.isOpen()) {
         std::cerr << "Error: Could not open file " << filepath << " for writing." << std::endl;
         return false;
 	}
-    file << content;
-    file.close();
-	return true;
+    if (!compiledTemplate(templateText).render(file, sections)) {
+        return false;
+    }
+    emittedBytes += file.bytesWritten();
+	return file.close();
 }
 
 // ==========================================
 // CodeEmitter 类实现
 // ==========================================
 
-CodeEmitter::CodeEmitter(): outputDir(nullptr) {}
+CodeEmitter::CodeEmitter(): outputDir(nullptr), emittedBytes(0) {}
 
 CodeEmitter::CodeEmitter(const std::string& dir)
+    : emittedBytes(0)
 {
     if (dir.empty()) {
         outputDir = nullptr;
@@ -74,6 +462,14 @@ CodeEmitter::~CodeEmitter()
 bool CodeEmitter::parseInputFile(const std::string& filepath,
     std::vector<TokenDefinition>& outTokens,
     std::vector<ProductionRule>& outGrammar) {
+    SymbolTypeMap ignoredTypes;
+    return parseInputFile(filepath, outTokens, outGrammar, ignoredTypes);
+}
+
+bool CodeEmitter::parseInputFile(const std::string& filepath,
+    std::vector<TokenDefinition>& outTokens,
+    std::vector<ProductionRule>& outGrammar,
+    SymbolTypeMap& outSymbolTypes) {
     std::ifstream file(filepath);
     if (!file.is_open()) {
         std::cerr << "Error: Could not open file " << filepath << std::endl;
@@ -112,6 +508,15 @@ bool CodeEmitter::parseInputFile(const std::string& filepath,
         line = trim(line);
         if (line.empty()) continue;
 
+        // %type 声明：%type <字段1, 字段2> 非终结符1 非终结符2 ...
+        if (line.compare(0, 5, "%type") == 0 && (line.size() == 5 || is_space(line[5]))) {
+            if (!parseTypeDeclaration(line.substr(5), outSymbolTypes)) {
+                std::cerr << "Error: Malformed %type declaration: " << line << std::endl;
+                return false;
+            }
+            continue;
+        }
+
         // 从行尾解析 token 名
         size_t end = line.size();
         size_t pos = end;
@@ -226,61 +631,154 @@ bool CodeEmitter::parseInputFile(const std::string& filepath,
     return true;
 }
 
-bool CodeEmitter::emitLexer(const DFATable& dfa) {
+bool CodeEmitter::emitLexer(const DFATable& dfa, const std::vector<KeywordDefinition>& keywords) {
     if (!generateFile(
         (outputDir != nullptr ? *outputDir + "/" + LEXER_FILENAME : LEXER_FILENAME) + ".h",
-        TEMPLATE_LEXER_H
+        TEMPLATE_LEXER_H, TemplateRenderer::SectionMap(), emittedBytes
     )) {
 		std::cerr << "[CodeEmitter] Failed to generate header file." << std::endl;
         return false;
     }
 
-    std::stringstream ssSwitch;
-    std::stringstream ssFinal;
+    TemplateRenderer::SectionMap sections;
+
+    // --- 生成 Switch 部分 ---
+    sections["DFA_SWITCH_CASE"] = [&](OutputSink& ssSwitch) {
+        for (const auto& row : dfa) {
+            ssSwitch << "            case " << row.stateID << ":\n";
+            bool first = true;
+            for (auto const& range : row.transitions) {
+                if (first) { 
+                    ssSwitch << "                if "; 
+                    first = false;
+                }
+                else { 
+                    ssSwitch << "                else if "; 
+                }
+
+                // 每个区间一个判断；c 为 unsigned char，0 与 255 两端的比较省略
+                if (range.low == range.high) ssSwitch << "(c == " << charLiteral(range.low) << ") ";
+                else if (range.low == 0 && range.high == 255) ssSwitch << "(true) ";
+                else if (range.low == 0) ssSwitch << "(c <= " << charLiteral(range.high) << ") ";
+                else if (range.high == 255) ssSwitch << "(c >= " << charLiteral(range.low) << ") ";
+                else ssSwitch << "(c >= " << charLiteral(range.low) << " && c <= " << charLiteral(range.high) << ") ";
 
-    for (const auto& row : dfa) {
-        // --- 生成 Switch 部分 ---
-        ssSwitch << "            case " << row.stateID << ":\n";
-        bool first = true;
-        for (auto const& pair : row.transitions) {
-            char key = pair.first;   // 获取字符
-            int target = pair.second; // 获取目标状态
-            if (first) { 
-                ssSwitch << "                if "; 
-                first = false;
+                ssSwitch << "nextState = " << range.target << ";\n";
             }
-            else { 
-                ssSwitch << "                else if "; 
+            ssSwitch << "                break;\n";
+        }
+    };
+
+    // --- 生成 Final State 判断部分 ---
+    // 覆盖关键字的规则 (如 ID) 识别出的词素先查关键字表
+    std::set<std::string> covers;
+    for (const auto& keyword : keywords) covers.insert(keyword.coverName);
+    sections["FINAL_STATE_JUDGEMENT"] = [&](OutputSink& ssFinal) {
+        for (const auto& row : dfa) {
+            if (row.isFinal) {
+                ssFinal << "            if (state == " << row.stateID << ") ";
+                if (covers.count(row.tokenName)) {
+                    ssFinal << "return Token{matchKeyword(currentText, \"" << row.tokenName << "\"), currentText, m_line};\n";
+                }
+                else {
+                    ssFinal << "return Token{\"" << row.tokenName << "\", currentText, m_line};\n";
+                }
             }
+        }
+    };
+
+    sections["KEYWORD_TABLES"] = [&](OutputSink& os) {
+        emitKeywordTables(os, keywords);
+    };
+
+    // --- 终态标记：最长匹配时记录最后经过的终态 ---
+    sections["ACCEPTING_STATES"] = [&](OutputSink& os) {
+        int stateCount = 1;
+        for (const auto& row : dfa) stateCount = std::max(stateCount, row.stateID + 1);
+        std::vector<int> accepting(stateCount, 0);
+        for (const auto& row : dfa) {
+            if (row.isFinal) accepting[row.stateID] = 1;
+        }
+        os << "static const int LEXER_STATE_COUNT = " << stateCount << ";\n";
+        emitIntArray(os, "bool", "LEXER_ACCEPTING", accepting);
+    };
 
-            // 处理特殊字符转义
-            if (key == '\n') ssSwitch << "(c == '\\n') ";
-            else if (key == '\t') ssSwitch << "(c == '\\t') ";
-			else if (key == '\r') ssSwitch << "(c == '\\r') ";
-            else ssSwitch << "(c == '" << key << "') ";
+    // 渲染模版 (Lexer.cpp)，各段在写文件时直接生成
+    if (!generateFile(
+        (outputDir != nullptr ? *outputDir + "/" + LEXER_FILENAME : LEXER_FILENAME) + ".cpp",
+        TEMPLATE_LEXER_CPP, sections, emittedBytes
+    )) {
+        std::cerr << "[CodeEmitter] Failed to generate implementation file." << std::endl;
+        return false;
+    }
 
-            ssSwitch << "nextState = " << target << ";\n";
-        }
-        ssSwitch << "                break;\n";
+    return true;
+}
 
-        // --- 生成 Final State 判断部分 ---
-        if (row.isFinal) {
-            ssFinal << "            if (state == " << row.stateID << ") "
-                << "return Token{\"" << row.tokenName << "\", currentText, m_line};\n";
-        }
+bool CodeEmitter::emitLazyLexer(const CompactNFA& nfa, const std::vector<KeywordDefinition>& keywords) {
+    if (!generateFile(
+        (outputDir != nullptr ? *outputDir + "/" + LEXER_FILENAME : LEXER_FILENAME) + ".h",
+        TEMPLATE_LEXER_H, TemplateRenderer::SectionMap(), emittedBytes
+    )) {
+        std::cerr << "[CodeEmitter] Failed to generate header file." << std::endl;
+        return false;
     }
 
-    // 渲染模版 (Lexer.cpp)
-    std::string cppContent = TEMPLATE_LEXER_CPP;
+    TemplateRenderer::SectionMap sections;
+
+    // --- 紧凑 NFA：epsilon 与字符转移都按状态分段存放 ---
+    sections["NFA_TABLES"] = [&](OutputSink& os) {
+        size_t count = nfa.accept.size();
+        std::vector<int> epsilonBegin(1, 0), epsilon, moveBegin(1, 0), moveLow, moveHigh, moveTarget;
+        for (size_t s = 0; s < count; ++s) {
+            epsilon.insert(epsilon.end(), nfa.epsilon[s].begin(), nfa.epsilon[s].end());
+            epsilonBegin.push_back((int)epsilon.size());
+            for (const auto& move : nfa.transitions[s]) {
+                moveLow.push_back(move.low);
+                moveHigh.push_back(move.high);
+                moveTarget.push_back(move.target);
+            }
+            moveBegin.push_back((int)moveLow.size());
+        }
+        // 空数组不合法，末尾补一个不会被访问的元素
+        epsilon.push_back(0);
+        moveLow.push_back(0);
+        moveHigh.push_back(0);
+        moveTarget.push_back(0);
+
+        os << "static const int NFA_STATE_COUNT = " << count << ";\n";
+        os << "static const int NFA_START = " << nfa.startState << ";\n";
+        os << "static const char* const NFA_TOKEN_NAMES[] = {";
+        for (size_t i = 0; i < nfa.tokenNames.size(); ++i) {
+            os << (i % 8 == 0 ? "\n    " : " ") << "\"" << escapeString(nfa.tokenNames[i]) << "\",";
+        }
+        os << "\n};\n";
+        emitIntArray(os, "int", "NFA_ACCEPT", nfa.accept);
+        emitIntArray(os, "int", "NFA_EPSILON_BEGIN", epsilonBegin);
+        emitIntArray(os, "int", "NFA_EPSILON", epsilon);
+        emitIntArray(os, "int", "NFA_MOVE_BEGIN", moveBegin);
+        emitIntArray(os, "unsigned char", "NFA_MOVE_LOW", moveLow);
+        emitIntArray(os, "unsigned char", "NFA_MOVE_HIGH", moveHigh);
+        emitIntArray(os, "int", "NFA_MOVE_TARGET", moveTarget);
+
+        // 每条规则是否覆盖关键字
+        std::vector<int> keywordCover;
+        for (const auto& name : nfa.tokenNames) {
+            bool cover = false;
+            for (const auto& keyword : keywords) cover = cover || keyword.coverName == name;
+            keywordCover.push_back(cover ? 1 : 0);
+        }
+        keywordCover.push_back(0);
+        emitIntArray(os, "char", "NFA_KEYWORD_COVER", keywordCover);
+    };
 
-    // 替换占位符
-    cppContent = replaceAll(cppContent, "{{DFA_SWITCH_CASE}}", ssSwitch.str());
-    cppContent = replaceAll(cppContent, "{{FINAL_STATE_JUDGEMENT}}", ssFinal.str());
+    sections["KEYWORD_TABLES"] = [&](OutputSink& os) {
+        emitKeywordTables(os, keywords);
+    };
 
-    // 写入文件
     if (!generateFile(
         (outputDir != nullptr ? *outputDir + "/" + LEXER_FILENAME : LEXER_FILENAME) + ".cpp",
-        cppContent
+        TEMPLATE_LAZY_LEXER_CPP, sections, emittedBytes
     )) {
         std::cerr << "[CodeEmitter] Failed to generate implementation file." << std::endl;
         return false;
@@ -291,129 +789,335 @@ bool CodeEmitter::emitLexer(const DFATable& dfa) {
 
 bool CodeEmitter::emitParser(const ActionTable& actionTbl,
     const GotoTable& gotoTbl,
-    const std::vector<ProductionRule>& rules) {
+    const std::vector<ProductionRule>& rules,
+    const SymbolTypeMap& symbolTypes) {
+
+    // 确定每个非终结符在值栈中的类型
+    // 只有真正会被归约压栈的非终结符才需要类型 (增广开始符号永远不会入栈)
+    std::set<std::string> nonterminals;
+    for (const auto& rule : rules) {
+        nonterminals.insert(rule.lhs);
+    }
+    std::set<std::string> pushedNonterminals;
+    for (const auto& entry : actionTbl) {
+        if (entry.second.type == ACTION_REDUCE) {
+            pushedNonterminals.insert(rules[entry.second.target].lhs);
+        }
+    }
 
-    if(!generateFile(
-        (outputDir != nullptr ? *outputDir + "/" + PARSER_FILENAME : PARSER_FILENAME) + ".h",
-        TEMPLATE_PARSER_H
-	)) {
-        std::cerr << "[CodeEmitter] Failed to generate parser header file." << std::endl;
-		return false;
-	}
+    for (const auto& decl : symbolTypes) {
+        if (nonterminals.count(decl.first) == 0) {
+            std::cout << "[CodeEmitter] Warning: %type for unknown nonterminal '" << decl.first << "' ignored." << std::endl;
+        }
+    }
+
+    std::map<std::string, std::string> valueTypeOf; // 非终结符 -> C++ 类型名
+    // std::monostate 放在首位，使值栈槽位可以默认构造 (空产生式归约前先压入占位值)
+    std::vector<std::string> stackTypes = { "std::monostate", "TokenValue" };
+    std::vector<const std::vector<std::string>*> valueStructFields = { nullptr, nullptr }; // 与 stackTypes 一一对应，非空表示需要生成结构体
+    for (const auto& nonTerm : pushedNonterminals) {
+        std::string typeName;
+        auto declIt = symbolTypes.find(nonTerm);
+        if (declIt == symbolTypes.end()) {
+            typeName = "SemanticValue";
+        }
+        else if (!valueTypeName(declIt->second, typeName)) {
+            std::cerr << "[CodeEmitter] Unknown field in %type declaration of '" << nonTerm << "'." << std::endl;
+            return false;
+        }
+        valueTypeOf[nonTerm] = typeName;
 
-	std::stringstream ssGoto;
-	std::stringstream ssAction;
+        if (std::find(stackTypes.begin(), stackTypes.end(), typeName) == stackTypes.end()) {
+            stackTypes.push_back(typeName);
+            bool hasStruct = declIt != symbolTypes.end() && !declIt->second.empty();
+            valueStructFields.push_back(hasStruct ? &declIt->second : nullptr);
+        }
+    }
 
-	// 生成 GOTO 表逻辑
-    for (const auto& entry : gotoTbl) {
-        int state = entry.first.first;
-		std::string nonTerm = entry.first.second;
-        int targetState = entry.second;
-        ssGoto << "    " << (ssGoto.str().empty() ? "" : "else ") << "if (state == " << state << " && lhs == \"" << nonTerm << "\") "
-			<< "return " << targetState << ";\n";
+    // 终结符统一使用 TokenValue
+    auto symbolValueType = [&](const std::string& symbol) -> std::string {
+        auto it = valueTypeOf.find(symbol);
+        if (it != valueTypeOf.end()) return it->second;
+        return nonterminals.count(symbol) ? "SemanticValue" : "TokenValue";
+    };
+
+    std::string stackTypeList;
+    for (size_t i = 0; i < stackTypes.size(); ++i) {
+        stackTypeList += (i == 0 ? "" : ", ") + stackTypes[i];
     }
 
-	// 生成 Action 表逻辑
-    for (const auto& entry : actionTbl)
+    int stateCount = countStates(actionTbl, gotoTbl);
+
+    // 终结符编号：按字典序 (生成的 Parser 用二分查找把 Token 类型映射为编号)
+    std::set<std::string> terminalSet;
+    for (const auto& entry : actionTbl) {
+        terminalSet.insert(entry.first.second);
+    }
+    std::vector<std::string> terminalNames(terminalSet.begin(), terminalSet.end());
+    std::map<std::string, int> terminalId;
+    for (size_t i = 0; i < terminalNames.size(); ++i) {
+        terminalId[terminalNames[i]] = (int)i;
+    }
+
+	// 非终结符编号：按在产生式左部首次出现的顺序
+    std::map<std::string, int> nonterminalId;
+    std::vector<std::string> nonterminalNames;
+    for (const auto& rule : rules) {
+        if (nonterminalId.count(rule.lhs) == 0) {
+            nonterminalId[rule.lhs] = (int)nonterminalNames.size();
+            nonterminalNames.push_back(rule.lhs);
+        }
+    }
+
+    // 表项类型：状态号与规则号都放得下时用 short
+    const char* tableEntryType = (stateCount < 32767 && rules.size() < 32767) ? "short" : "int";
+
+    // 语义动作函数：每条规则的函数体先生成为文本，相同的函数体只生成一个函数
+    // 规则 0 是增广规则，对它的归约即接受，不需要语义动作函数
+    struct ReduceFunction {
+        std::string name;
+        std::string body;
+        std::vector<int> ruleIds; // 共用该函数的规则
+    };
+    std::vector<ReduceFunction> reduceFunctions;
+    std::vector<int> ruleFunction(rules.size(), -1); // 规则 -> reduceFunctions 下标，-1 表示不调用
     {
-		int state = entry.first.first;
-        std::string symbol = entry.first.second;
-		LRAction action = entry.second;
-
-		ssAction << "        " << (ssAction.str().empty() ? "" : "else ") << "if (state == " << state << " && lookahead.type == \"" << symbol << "\") {\n";
-        switch (action.type)
-        {
-        case ACTION_SHIFT:
-            ssAction << "            // Shift to state " << action.target << "\n"
-                     << "            m_stateStack.push(" << action.target << ");\n"
-                     << "            m_valueStack.push(SemanticValue{lookahead.text, lookahead.line});\n"
-                     << "            lookahead = m_lexer.nextToken();\n";
-			break;
-		case ACTION_REDUCE:
-        {
-            // 1. 获取对应的产生式规则
-            const ProductionRule& rule = rules[action.target];
+        std::map<std::string, int> functionByBody;
+        for (size_t r = 1; r < rules.size(); ++r) {
+            const ProductionRule& rule = rules[r];
             int rhsCount = (int)rule.rhs.size();
+            std::string lhsType = symbolValueType(rule.lhs);
 
-            // --- 新增：构造易读的产生式字符串 ---
-            std::string ruleDisp = rule.lhs + " -> ";
-            if (rule.rhs.empty()) {
-                ruleDisp += "ε"; // 处理空产生式
+            // 没有动作的规则不调用任何函数：左部不携带值，或槽位中已经是同类型的 $1 (即 yacc 的默认 $$ = $1)
+            if (isEmptyAction(rule.semanticAction) &&
+                (lhsType == "std::monostate" || (rhsCount > 0 && symbolValueType(rule.rhs[0]) == lhsType))) {
+                continue;
             }
-            else {
-                for (size_t i = 0; i < rule.rhs.size(); ++i) {
-                    ruleDisp += rule.rhs[i] + (i == rule.rhs.size() - 1 ? "" : " ");
+
+            // 处理语义动作中的引用 ($$ -> res, $1 -> v1, etc.)
+            std::set<int> usedRefs;
+            std::string processedAction = substituteActionRefs(rule.semanticAction, rhsCount, usedRefs);
+
+            std::stringstream body;
+            for (int i : usedRefs) {
+                std::string valueType = symbolValueType(rule.rhs[i - 1]);
+                if (valueType == "std::monostate") {
+                    body << "    std::monostate v" << i << ";\n"; // 不携带值的符号，其槽位内容没有意义
+                }
+                else {
+                    body << "    " << valueType << "& v" << i << " = std::get<" << valueType << ">(rhs[" << (i - 1) << "]);\n";
                 }
             }
+            // 准备结果变量 (除 std::monostate 外都在 Arena 上构造)
+            body << "    " << lhsType << (lhsType == "std::monostate" ? " res;\n" : " res(&m_arena);\n");
+            if (!isEmptyAction(rule.semanticAction)) {
+                body << "    " << processedAction << "\n"; // 插入用户写的代码
+            }
+            body << "    out = std::move(res);\n";
+
+            std::string signature = std::string("(StackValue*") + (usedRefs.empty() ? "" : " rhs") + ", StackValue& out)";
+            std::string key = signature + body.str();
+            auto found = functionByBody.find(key);
+            if (found == functionByBody.end()) {
+                ReduceFunction fn;
+                fn.name = "reduce_" + std::to_string(rule.id);
+                fn.body = "void Parser::" + fn.name + signature + " {\n" + body.str() + "}\n";
+                found = functionByBody.emplace(key, (int)reduceFunctions.size()).first;
+                reduceFunctions.push_back(fn);
+            }
+            reduceFunctions[found->second].ruleIds.push_back(rule.id);
+            ruleFunction[r] = found->second;
+        }
+    }
+
+    // 渲染模版 (Parser.h)
+    TemplateRenderer::SectionMap headerSections;
+    headerSections["VALUE_TYPES"] = [&](OutputSink& out) {
+        for (size_t i = 0; i < valueStructFields.size(); ++i) {
+            if (valueStructFields[i] != nullptr) {
+                emitValueStruct(out, stackTypes[i], *valueStructFields[i]);
+            }
+        }
+    };
+    headerSections["STACK_VALUE_TYPES"] = TemplateRenderer::text(stackTypeList);
+    headerSections["PIPELINE_DEFAULT"] = TemplateRenderer::text(options.pipeline ? "1" : "0");
+    headerSections["RULE_COUNT"] = TemplateRenderer::text(std::to_string(rules.size()));
+    headerSections["STATE_COUNT"] = TemplateRenderer::text(std::to_string(stateCount));
+    headerSections["TERMINAL_COUNT"] = TemplateRenderer::text(std::to_string(terminalNames.size()));
+    headerSections["NONTERMINAL_COUNT"] = TemplateRenderer::text(std::to_string(nonterminalNames.size()));
+    headerSections["TABLE_ENTRY_TYPE"] = TemplateRenderer::text(tableEntryType);
+    headerSections["ACTION_DECLS"] = [&](OutputSink& out) {
+        for (const auto& fn : reduceFunctions) {
+            out << "    void " << fn.name << "(StackValue* rhs, StackValue& out);\n";
+        }
+    };
 
-            // 在生成的代码中添加打印语句
-            ssAction << "            // Reduce Rule " << rule.id << ": " << ruleDisp << "\n";
-            ssAction << "            std::cout << \"[Reduce] " << ruleDisp << "\" << std::endl;\n";
+    if(!generateFile(
+        (outputDir != nullptr ? *outputDir + "/" + PARSER_FILENAME : PARSER_FILENAME) + ".h",
+        TEMPLATE_PARSER_H, headerSections, emittedBytes
+	)) {
+        std::cerr << "[CodeEmitter] Failed to generate parser header file." << std::endl;
+		return false;
+	}
 
-            // 2. 生成弹栈代码
-            for (int i = rhsCount; i >= 1; --i) {
-                ssAction << "            SemanticValue v" << i << " = m_valueStack.top();\n"
-                    << "            m_valueStack.pop();\n"
-                    << "            m_stateStack.pop();\n";
+    // 表数据：ACTION 表、规则信息与 GOTO 表
+    auto emitTableData = [&](OutputSink& out) {
+        std::vector<int> actionData(stateCount * terminalNames.size(), 0);
+        for (const auto& entry : actionTbl) {
+            int index = entry.first.first * (int)terminalNames.size() + terminalId[entry.first.second];
+            const LRAction& action = entry.second;
+            switch (action.type) {
+            case ACTION_SHIFT:  actionData[index] = action.target + 1; break;
+            case ACTION_REDUCE: actionData[index] = -(action.target + 1); break;
+            case ACTION_ACCEPT: actionData[index] = -1; break;
+            default:            actionData[index] = 0; break;
             }
+        }
 
-            // 3. 处理语义动作字符串替换 ($$ -> res, $1 -> v1, etc.)
-            std::string processedAction = rule.semanticAction;
+        std::vector<int> ruleLength, ruleLhs;
+        for (const auto& rule : rules) {
+            ruleLength.push_back((int)rule.rhs.size());
+            ruleLhs.push_back(nonterminalId[rule.lhs]);
+        }
 
-            // 替换 $$ 为 res
-            processedAction = replaceAll(processedAction, "$$", "res");
+        out << "\n// ---------------------------------------------------------\n"
+            << "//  分析表数据 (自动生成)\n"
+            << "// ---------------------------------------------------------\n\n";
+        out << "// ACTION 表: " << stateCount << " 个状态 x " << terminalNames.size() << " 个终结符\n";
+        emitIntArray(out, "ParserTableEntry", "PARSER_ACTION", actionData);
 
-            // 替换 $1, $2... 为 v1, v2...
-            for (int i = rhsCount; i >= 1; --i) {
-                std::string target = "$" + std::to_string(i);
-                std::string replacement = "v" + std::to_string(i);
-                processedAction = replaceAll(processedAction, target, replacement);
-            }
+        out << "\nconst char* const PARSER_TERMINAL_NAMES[] = {\n";
+        for (const auto& name : terminalNames) {
+            out << "    \"" << escapeString(name) << "\",\n";
+        }
+        out << "};\n\n";
+
+        emitIntArray(out, "ParserTableEntry", "PARSER_RULE_LENGTH", ruleLength);
+        emitIntArray(out, "ParserTableEntry", "PARSER_RULE_LHS", ruleLhs);
+        out << "\nconst char* const PARSER_RULE_NAMES[] = {\n";
+        for (const auto& rule : rules) {
+            out << "    \"" << escapeString(ruleDisplay(rule)) << "\",\n";
+        }
+        out << "};\n\n";
 
-            // 4. 生成执行语义动作的代码
-            ssAction << "            SemanticValue res;\n"; // 准备结果变量
-            ssAction << "            " << processedAction << "\n"; // 插入用户写的代码
-
-            // 5. 查 GOTO 表并压入新状态
-            ssAction << "            int nextState = getGoto(m_stateStack.top(), \"" << rule.lhs << "\");\n"
-                << "            m_stateStack.push(nextState);\n"
-                << "            m_valueStack.push(res);\n";
-        }
-            break;
-		case ACTION_ACCEPT:
-            ssAction << "            printGeneratedCode();\n"
-                     << "            // Accept\n"
-                     << "            return true;\n";
-			break;
-        case ACTION_ERROR:
-            ssAction << "            // Error\n"
-                     << "            reportError(lookahead);\n"
-                     << "            return false;\n";
-			break;
-        default:
-            break;
-        }
-		ssAction << "        }\n";
-    }
-    ssAction << "        else {\n"
-             << "            // Error\n"
-             << "            reportError(lookahead);\n"
-             << "            return false;\n"
-		<< "        }\n";
+        emitGotoTables(out, gotoTbl, nonterminalId, nonterminalNames, stateCount);
+
+        // 规则 -> 语义动作函数
+        out << "\nconst Parser::ReduceFn Parser::REDUCE_TABLE[] = {\n";
+        for (size_t r = 0; r < rules.size(); ++r) {
+            if (ruleFunction[r] < 0) {
+                out << "    nullptr,\n";
+            }
+            else {
+                out << "    &Parser::" << reduceFunctions[ruleFunction[r]].name << ",\n";
+            }
+        }
+        out << "};\n";
+    };
+
+    // 语义动作函数 (注释列出共用它的所有规则)
+    auto emitReduceFunction = [&](OutputSink& out, const ReduceFunction& fn) {
+        out << "\n";
+        for (int ruleId : fn.ruleIds) {
+            out << "// Rule " << ruleId << ": " << ruleDisplay(rules[ruleId]) << "\n";
+        }
+        out << fn.body;
+    };
 
 	// 渲染模版 (Parser.cpp)
-	std::string cppContent = TEMPLATE_PARSER_CPP;
-	// 替换占位符
-	cppContent = replaceAll(cppContent, "{{GOTO_TABLE_LOGIC}}", ssGoto.str());
-	cppContent = replaceAll(cppContent, "{{ACTION_TABLE_LOGIC}}", ssAction.str());
-	// 写入文件
+	TemplateRenderer::SectionMap sections;
+
+    // 分片：按代码量把语义动作函数分给各分片 (贪心，先放大的)，每个分片内保持原有顺序
+    int shardCount = options.shards > 1 ? options.shards : 1;
+    std::vector<std::vector<size_t>> shards(shardCount);
+    {
+        std::vector<size_t> order;
+        for (size_t f = 0; f < reduceFunctions.size(); ++f) order.push_back(f);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return reduceFunctions[a].body.size() > reduceFunctions[b].body.size();
+        });
+        std::vector<size_t> shardSize(shardCount, 0);
+        for (size_t f : order) {
+            size_t lightest = std::min_element(shardSize.begin(), shardSize.end()) - shardSize.begin();
+            shards[lightest].push_back(f);
+            shardSize[lightest] += reduceFunctions[f].body.size();
+        }
+        for (auto& shard : shards) std::sort(shard.begin(), shard.end());
+    }
+
+    auto emitShard = [&](OutputSink& out, size_t shard) {
+        for (size_t f : shards[shard]) {
+            emitReduceFunction(out, reduceFunctions[f]);
+        }
+    };
+
+    if (shardCount == 1) {
+        // 单文件模式：表数据与语义动作都放在 parser.cpp 末尾
+        sections["TABLE_DATA"] = emitTableData;
+        sections["ACTION_FUNCTIONS"] = [&](OutputSink& out) { emitShard(out, 0); };
+    }
+    else {
+        sections["TABLE_DATA"] = TemplateRenderer::text("");
+        sections["ACTION_FUNCTIONS"] = TemplateRenderer::text("");
+    }
+
     if (!generateFile(
         (outputDir != nullptr ? *outputDir + "/" + PARSER_FILENAME : PARSER_FILENAME) + ".cpp",
-        cppContent
+        TEMPLATE_PARSER_CPP, sections, emittedBytes
     )) {
         std::cerr << "[CodeEmitter] Failed to generate parser implementation file." << std::endl;
         return false;
 	}
 
+    // 删除上一次以更多分片 (或分片模式) 生成的多余文件，否则 parser*.cpp 会重复定义
+    std::string parserPath = outputDir != nullptr ? *outputDir + "/" + PARSER_FILENAME : PARSER_FILENAME;
+    if (shardCount == 1) {
+        std::remove((parserPath + "_tables.cpp").c_str());
+    }
+    for (int shard = shardCount == 1 ? 0 : shardCount;
+         std::remove((parserPath + "_actions_" + std::to_string(shard) + ".cpp").c_str()) == 0; ++shard) {
+    }
+
+    if (shardCount == 1) {
+        return true;
+    }
+
+    // 分片模式：表数据单独一个编译单元，语义动作分成 shardCount 个编译单元，可并行编译
+    TemplateRenderer::SectionMap tableSections;
+    tableSections["TABLE_DATA"] = emitTableData;
+    if (!generateFile(
+        (outputDir != nullptr ? *outputDir + "/" + PARSER_FILENAME : PARSER_FILENAME) + "_tables.cpp",
+        TEMPLATE_PARSER_TABLES_CPP, tableSections, emittedBytes
+    )) {
+        std::cerr << "[CodeEmitter] Failed to generate parser table file." << std::endl;
+        return false;
+    }
+
+    for (int shard = 0; shard < shardCount; ++shard) {
+        TemplateRenderer::SectionMap shardSections;
+        shardSections["SHARD_INDEX"] = TemplateRenderer::text(std::to_string(shard));
+        shardSections["SHARD_COUNT"] = TemplateRenderer::text(std::to_string(shardCount));
+        shardSections["ACTION_FUNCTIONS"] = [&](OutputSink& out) { emitShard(out, (size_t)shard); };
+        if (!generateFile(
+            (outputDir != nullptr ? *outputDir + "/" + PARSER_FILENAME : PARSER_FILENAME) + "_actions_" + std::to_string(shard) + ".cpp",
+            TEMPLATE_PARSER_ACTIONS_CPP, shardSections, emittedBytes
+        )) {
+            std::cerr << "[CodeEmitter] Failed to generate parser action shard " << shard << "." << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool CodeEmitter::emitBatchDriver() {
+    if (!generateFile(
+        (outputDir != nullptr ? *outputDir + "/" + BATCH_FILENAME : BATCH_FILENAME) + ".cpp",
+        TEMPLATE_BATCH_MAIN_CPP, TemplateRenderer::SectionMap(), emittedBytes
+    )) {
+        std::cerr << "[CodeEmitter] Failed to generate batch driver." << std::endl;
+        return false;
+    }
+
     return true;
 }
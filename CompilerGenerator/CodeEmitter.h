@@ -3,21 +3,45 @@
 #include "Types.h"
 #include <string>
 
+// 代码生成选项 (由命令行决定)
+struct EmitterOptions {
+    bool pipeline = false; // 生成的 Parser 默认启用词法线程流水线 (PARSER_PIPELINE=1)
+    int shards = 0;        // > 1 时把表数据和语义动作拆分到多个编译单元 (parser_tables.cpp, parser_actions_N.cpp)
+};
+
 class CodeEmitter {
 public:
     CodeEmitter();
     CodeEmitter(const std::string& dir);
     ~CodeEmitter();
 
+    void setOptions(const EmitterOptions& opts) { options = opts; }
+
+    // 到目前为止生成的代码总字节数
+    size_t getEmittedBytes() const { return emittedBytes; }
+
     // 1. 生成词法分析器代码 (lex.cpp / lex.h)
     // 根据 DFA 表，生成 switch-case 跳转代码
-    bool emitLexer(const DFATable& dfa);
+    // keywords: 不在 DFA 中的关键字，生成完美哈希表对覆盖规则识别出的词素改判
+    bool emitLexer(const DFATable& dfa,
+        const std::vector<KeywordDefinition>& keywords = std::vector<KeywordDefinition>());
+
+    // 1.1 生成惰性 DFA 词法分析器 (DFA 状态超出上限时使用)
+    // 嵌入紧凑 NFA，运行时按需构造 DFA 状态并缓存
+    bool emitLazyLexer(const CompactNFA& nfa,
+        const std::vector<KeywordDefinition>& keywords = std::vector<KeywordDefinition>());
 
     // 2. 生成语法分析器代码 (parser.cpp / parser.h)
     // 根据 LR 表和产生式，生成栈操作代码和语义动作 switch-case
+    // symbolTypes: %type 声明，决定每个非终结符在值栈中的具体类型
     bool emitParser(const ActionTable& actionTbl,
         const GotoTable& gotoTbl,
-        const std::vector<ProductionRule>& rules);
+        const std::vector<ProductionRule>& rules,
+        const SymbolTypeMap& symbolTypes = SymbolTypeMap());
+
+    // 3. 生成批处理驱动 (batch_main.cpp)
+    // 用线程池并行编译一批源文件，每个线程一套 Lexer/Parser
+    bool emitBatchDriver();
 
     // 辅助：读取用户输入的规则文件 (.txt)，并解析内容填充到 vector<string> 中供 A 和 B 使用
     // 返回值：是否读取成功
@@ -25,6 +49,14 @@ public:
         std::vector<TokenDefinition>& outTokens,
         std::vector<ProductionRule>& outGrammar);
 
+    // 同上，额外收集词法部分中的 %type 声明
+    bool parseInputFile(const std::string& filepath,
+        std::vector<TokenDefinition>& outTokens,
+        std::vector<ProductionRule>& outGrammar,
+        SymbolTypeMap& outSymbolTypes);
+
 private: 
 	std::string* outputDir;
+    EmitterOptions options;
+    size_t emittedBytes;
 };
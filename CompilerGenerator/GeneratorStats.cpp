@@ -0,0 +1,210 @@
+#include "GeneratorStats.h"
+#include <fstream>
+#include <iomanip>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+// ==========================================
+// 全局 operator new 计数
+// 替换全局分配函数，只做计数，真正的分配仍交给 malloc
+// 计数打开后每次分配有两次原子加，多线程构造时会争用同一缓存行，因此只在需要统计时打开
+// ==========================================
+
+static std::atomic<bool> g_countAllocations(false);
+static std::atomic<unsigned long long> g_allocCount(0);
+static std::atomic<unsigned long long> g_allocBytes(0);
+
+static void* countedAlloc(std::size_t size) {
+    if (g_countAllocations.load(std::memory_order_relaxed)) {
+        g_allocCount.fetch_add(1, std::memory_order_relaxed);
+        g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+void GeneratorStats::setAllocationCounting(bool enable) {
+    g_countAllocations.store(enable, std::memory_order_relaxed);
+}
+
+unsigned long long GeneratorStats::allocationCount() {
+    return g_allocCount.load(std::memory_order_relaxed);
+}
+
+unsigned long long GeneratorStats::allocatedBytes() {
+    return g_allocBytes.load(std::memory_order_relaxed);
+}
+
+long long GeneratorStats::peakRssKB() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        return (long long)(pmc.PeakWorkingSetSize / 1024);
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return (long long)(usage.ru_maxrss / 1024); // macOS 以字节为单位
+#else
+    return (long long)usage.ru_maxrss;
+#endif
+#endif
+}
+
+// ==========================================
+// GeneratorStats 实现
+// ==========================================
+
+GeneratorStats::GeneratorStats() : m_start(std::chrono::steady_clock::now()) {}
+
+double GeneratorStats::elapsedMs() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+}
+
+void GeneratorStats::beginPhase(const std::string& name) {
+    Phase phase;
+    phase.name = name;
+    phase.depth = (int)m_open.size();
+    phase.startMs = elapsedMs();
+    phase.wallMs = 0;
+    // 先记下起点的累计值，结束时换成差值
+    phase.allocations = allocationCount();
+    phase.bytes = allocatedBytes();
+    phase.peakRssKB = 0;
+    m_open.push_back(m_phases.size());
+    m_phases.push_back(phase);
+}
+
+void GeneratorStats::endPhase() {
+    if (m_open.empty()) return;
+    Phase& phase = m_phases[m_open.back()];
+    m_open.pop_back();
+    phase.wallMs = elapsedMs() - phase.startMs;
+    phase.allocations = allocationCount() - phase.allocations;
+    phase.bytes = allocatedBytes() - phase.bytes;
+    phase.peakRssKB = peakRssKB();
+}
+
+void GeneratorStats::setCounter(const std::string& name, long long value) {
+    for (auto& counter : m_counters) {
+        if (counter.first == name) {
+            counter.second = value;
+            return;
+        }
+    }
+    m_counters.push_back(std::make_pair(name, value));
+}
+
+double GeneratorStats::phaseMs(const std::string& name) const {
+    for (size_t i = m_phases.size(); i > 0; --i) {
+        if (m_phases[i - 1].name == name) return m_phases[i - 1].wallMs;
+    }
+    return -1;
+}
+
+long long GeneratorStats::counter(const std::string& name) const {
+    for (const auto& counter : m_counters) {
+        if (counter.first == name) return counter.second;
+    }
+    return -1;
+}
+
+// 阶段名与计数名都由生成器内部给出，不含需要转义的字符
+bool GeneratorStats::writeJson(const std::string& path, const std::string& inputFile) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << path << " for writing." << std::endl;
+        return false;
+    }
+
+    file << std::fixed << std::setprecision(3);
+    file << "{\n";
+    file << "  \"input\": \"";
+    for (char c : inputFile) {
+        if (c == '"' || c == '\\') file << '\\';
+        file << c;
+    }
+    file << "\",\n";
+    file << "  \"totalMs\": " << elapsedMs() << ",\n";
+    file << "  \"allocations\": " << allocationCount() << ",\n";
+    file << "  \"allocatedBytes\": " << allocatedBytes() << ",\n";
+    file << "  \"peakRssKB\": " << peakRssKB() << ",\n";
+
+    file << "  \"phases\": [";
+    for (size_t i = 0; i < m_phases.size(); ++i) {
+        const Phase& p = m_phases[i];
+        file << (i == 0 ? "\n" : ",\n")
+             << "    {\"name\": \"" << p.name << "\", \"depth\": " << p.depth
+             << ", \"startMs\": " << p.startMs << ", \"wallMs\": " << p.wallMs
+             << ", \"allocations\": " << p.allocations << ", \"allocatedBytes\": " << p.bytes
+             << ", \"peakRssKB\": " << p.peakRssKB << "}";
+    }
+    file << "\n  ],\n";
+
+    file << "  \"sizes\": {";
+    for (size_t i = 0; i < m_counters.size(); ++i) {
+        file << (i == 0 ? "\n" : ",\n") << "    \"" << m_counters[i].first << "\": " << m_counters[i].second;
+    }
+    file << "\n  }\n";
+    file << "}\n";
+    return true;
+}
+
+// Chrome trace-event 格式：每个阶段一个 "X" (complete) 事件，时间单位为微秒
+bool GeneratorStats::writeChromeTrace(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << path << " for writing." << std::endl;
+        return false;
+    }
+
+    file << std::fixed << std::setprecision(1);
+    file << "{\"traceEvents\": [";
+    for (size_t i = 0; i < m_phases.size(); ++i) {
+        const Phase& p = m_phases[i];
+        file << (i == 0 ? "\n" : ",\n")
+             << "  {\"name\": \"" << p.name << "\", \"cat\": \"generator\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1"
+             << ", \"ts\": " << p.startMs * 1000.0 << ", \"dur\": " << p.wallMs * 1000.0
+             << ", \"args\": {\"allocations\": " << p.allocations << ", \"allocatedBytes\": " << p.bytes
+             << ", \"peakRssKB\": " << p.peakRssKB << "}}";
+    }
+    file << "\n], \"displayTimeUnit\": \"ms\"}\n";
+    return true;
+}
+
+void GeneratorStats::printSummary(std::ostream& os) const {
+    std::ios::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(2);
+    os << "   Phase                          Wall(ms)     Allocs      Bytes   PeakRSS(KB)" << std::endl;
+    for (const auto& p : m_phases) {
+        std::string name = std::string(p.depth * 2, ' ') + p.name;
+        os << "   " << std::left << std::setw(28) << name << std::right
+           << std::setw(10) << p.wallMs
+           << std::setw(11) << p.allocations
+           << std::setw(11) << p.bytes
+           << std::setw(14) << p.peakRssKB << std::endl;
+    }
+    for (const auto& counter : m_counters) {
+        os << "   " << counter.first << " = " << counter.second << std::endl;
+    }
+    os.flags(flags);
+}
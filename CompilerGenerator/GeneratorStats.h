@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+// 生成器统计 (--stats)
+// 记录每个阶段的墙钟时间、内存分配次数/字节数与进程峰值 RSS，以及各种规模计数，
+// 结果输出为 JSON，并可输出 Chrome trace-event 格式的时间线 (chrome://tracing 或 Perfetto 打开)
+class GeneratorStats {
+public:
+    GeneratorStats();
+
+    // 阶段可以嵌套；endPhase 结束最近一个未结束的阶段
+    void beginPhase(const std::string& name);
+    void endPhase();
+
+    // 规模计数 (同名覆盖，按首次设置的顺序输出)
+    void setCounter(const std::string& name, long long value);
+
+    // 查询：最近一个同名阶段的墙钟时间 (ms) / 计数值，不存在时返回 -1
+    double phaseMs(const std::string& name) const;
+    long long counter(const std::string& name) const;
+
+    bool writeJson(const std::string& path, const std::string& inputFile) const;
+    bool writeChromeTrace(const std::string& path) const;
+    void printSummary(std::ostream& os) const;
+
+    // 进程级数据：全局 operator new 的累计次数与字节数、峰值 RSS (KB)
+    // 分配计数默认关闭 (每次分配只多一次普通读)，--stats 或基准测试在开始前打开
+    static void setAllocationCounting(bool enable);
+    static unsigned long long allocationCount();
+    static unsigned long long allocatedBytes();
+    static long long peakRssKB();
+
+private:
+    struct Phase {
+        std::string name;
+        int depth;
+        double startMs;
+        double wallMs;
+        unsigned long long allocations;
+        unsigned long long bytes;
+        long long peakRssKB; // 阶段结束时的进程峰值 RSS
+    };
+
+    double elapsedMs() const;
+
+    std::chrono::steady_clock::time_point m_start;
+    std::vector<Phase> m_phases;
+    std::vector<size_t> m_open; // 未结束阶段在 m_phases 中的下标
+    std::vector<std::pair<std::string, long long>> m_counters;
+};
+
+// RAII：作用域内计为一个阶段；stats 为空时什么也不做
+class StatsPhase {
+public:
+    StatsPhase(GeneratorStats* stats, const std::string& name) : m_stats(stats) {
+        if (m_stats != nullptr) m_stats->beginPhase(name);
+    }
+    ~StatsPhase() {
+        if (m_stats != nullptr) m_stats->endPhase();
+    }
+
+private:
+    StatsPhase(const StatsPhase&) = delete;
+    StatsPhase& operator=(const StatsPhase&) = delete;
+
+    GeneratorStats* m_stats;
+};
@@ -1,256 +1,243 @@
 #include "LexerGenerator.h"
+#include "GeneratorStats.h"
 #include <stack>
 #include <queue>
 #include <algorithm>
 #include <cctype>
+#include <atomic>
+#include <thread>
 
-LexerGenerator::LexerGenerator() : nextStateID(0) {}
+// 任务数少于此值时不开线程，线程的创建开销超过收益
+static const size_t PARALLEL_MIN_TASKS = 32;
 
-void LexerGenerator::addRule(const std::string &tokenName, const std::string &regex)
-{
-    TokenDefinition def;
-    def.name = tokenName;
-    def.pattern = regex;
-    rules.push_back(def);
-}
-
-void LexerGenerator::build()
+// 用 threads 个线程执行 body(0) ~ body(count - 1)，各线程从原子计数器领取下标；调用线程也参与
+static void parallelFor(size_t count, unsigned int threads, const std::function<void(size_t)> &body)
 {
-    if (rules.empty())
-        return;
-
-    std::vector<NFA> nfas;
-
-    // 为每条规则构建 NFA
-    for (const auto &rule : rules)
+    if (threads <= 1 || count < PARALLEL_MIN_TASKS)
     {
-        NFA nfa = regexToNFA(rule.pattern, rule.name);
-        nfas.push_back(nfa);
+        for (size_t i = 0; i < count; i++)
+            body(i);
+        return;
     }
 
-    // 合并所有 NFA
-    NFA mergedNFA = mergeNFAs(nfas);
+    std::atomic<size_t> nextIndex(0);
+    auto worker = [&]() {
+        for (size_t i = nextIndex++; i < count; i = nextIndex++)
+            body(i);
+    };
+    std::vector<std::thread> pool;
+    for (unsigned int t = 1; t < threads; t++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto &thread : pool)
+        thread.join();
+}
 
-    // NFA -> DFA (子集构造法)
-    nfaToDFA(mergedNFA);
+LexerGenerator::LexerGenerator()
+    : nextStateID(0), stats(nullptr), dfaStateBudget(DEFAULT_DFA_STATE_BUDGET), forceLazyDFA(false), lazyDFA(false),
+      keywordHashing(true), construction(LEXER_THOMPSON), threads(1) {}
 
-    // DFA 最小化
-    minimizeDFA();
+void LexerGenerator::setDFAStateBudget(size_t maxStates)
+{
+    dfaStateBudget = maxStates;
 }
 
-const DFATable &LexerGenerator::getDFATable() const
+void LexerGenerator::setForceLazyDFA(bool force)
 {
-    return dfaTable;
+    forceLazyDFA = force;
 }
 
-// 预处理正则表达式：展开字符类，处理转义
-std::string LexerGenerator::preprocessRegex(const std::string &regex)
+void LexerGenerator::setKeywordHashing(bool enable)
 {
-    std::string result;
-    size_t i = 0;
+    keywordHashing = enable;
+}
 
-    while (i < regex.size())
-    {
-        if (regex[i] == '\\' && i + 1 < regex.size())
-        {
-            // 转义字符
-            char next = regex[i + 1];
-            if (next == 'd')
-            {
-                result += "[0-9]";
-                i += 2;
-            }
-            else if (next == 'w')
-            {
-                result += "[a-zA-Z0-9_]";
-                i += 2;
-            }
-            else if (next == 's')
-            {
-                result += "[ \\t\\n\\r]";
-                i += 2;
-            }
-            else
-            {
-                // 保留转义序列
-                result += regex[i];
-                result += regex[i + 1];
-                i += 2;
-            }
-        }
-        else if (regex[i] == '[')
-        {
-            // 字符类，直接复制到结束
-            while (i < regex.size() && regex[i] != ']')
-            {
-                result += regex[i];
-                i++;
-            }
-            if (i < regex.size())
-            {
-                result += regex[i]; // ']'
-                i++;
-            }
-        }
-        else
-        {
-            result += regex[i];
-            i++;
-        }
-    }
+void LexerGenerator::setConstruction(LexerConstruction construction)
+{
+    this->construction = construction;
+}
 
-    return result;
+void LexerGenerator::setThreads(unsigned int threads)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    this->threads = threads;
 }
 
-// 判断是否是操作符
-static bool isOperator(char c)
+void LexerGenerator::setStats(GeneratorStats *stats)
 {
-    return c == '|' || c == '*' || c == '+' || c == '?' || c == '.' || c == '(' || c == ')';
+    this->stats = stats;
 }
 
-// 获取操作符优先级
-static int getPrecedence(char op)
+void LexerGenerator::addRule(const std::string &tokenName, const std::string &regex)
 {
-    switch (op)
-    {
-    case '|':
-        return 1;
-    case '.':
-        return 2; // 连接
-    case '*':
-    case '+':
-    case '?':
-        return 3;
-    default:
-        return 0;
-    }
+    TokenDefinition def;
+    def.name = tokenName;
+    def.pattern = regex;
+    rules.push_back(def);
 }
 
-// 插入显式连接符并转为后缀表达式
-std::string LexerGenerator::regexToPostfix(const std::string &regex)
+void LexerGenerator::build()
 {
-    std::string processed = preprocessRegex(regex);
-    std::string withConcat;
+    if (rules.empty())
+        return;
 
-    // 插入显式连接符 '.'
-    for (size_t i = 0; i < processed.size(); i++)
-    {
-        char c = processed[i];
-        withConcat += c;
+    std::vector<TokenDefinition> activeRules;
+    std::vector<RegexPtr> activeTrees;
+    NFA mergedNFA;
+    bool fits = false;
+    lazyDFA = false;
 
-        if (i + 1 < processed.size())
+    // 正则 -> 语法树 (化简后)，三种构造方法共用
+    {
+        StatsPhase phase(stats, "lexer.ast");
+        std::vector<RegexPtr> trees;
+        for (const auto &rule : rules)
         {
-            char next = processed[i + 1];
-
-            // 当前字符后需要连接符的情况
-            bool needConcat = false;
-
-            if (c == '\\')
-            {
-                // 转义序列，跳过下一个字符
-                i++;
-                if (i < processed.size())
-                {
-                    withConcat += processed[i];
-                    if (i + 1 < processed.size())
-                    {
-                        next = processed[i + 1];
-                        needConcat = (next != ')' && next != '|' && next != '*' && next != '+' && next != '?');
-                    }
-                }
-            }
-            else if (c == '[')
-            {
-                // 字符类，找到 ']'
-                while (i + 1 < processed.size() && processed[i] != ']')
-                {
-                    i++;
-                    withConcat += processed[i];
-                }
-                if (i + 1 < processed.size())
-                {
-                    next = processed[i + 1];
-                    needConcat = (next != ')' && next != '|' && next != '*' && next != '+' && next != '?');
-                }
-            }
-            else if (c != '(' && c != '|')
-            {
-                needConcat = (next != ')' && next != '|' && next != '*' && next != '+' && next != '?');
-            }
-
-            if (needConcat)
+            trees.push_back(simplifyRegex(parseRegex(rule.pattern)));
+        }
+        // 被标识符规则覆盖的关键字不进入 DFA；每条规则的位置自动机在第一次用到时构造
+        std::map<size_t, PositionAutomaton> matchers;
+        std::vector<bool> removed = extractKeywords(trees, [&](size_t j, const std::string &text) {
+            auto it = matchers.find(j);
+            if (it == matchers.end())
             {
-                withConcat += '.';
+                it = matchers.insert(std::make_pair(j, PositionAutomaton())).first;
+                it->second.addRule(trees[j], 0);
+                it->second.finish();
             }
+            return regexMatches(it->second, text);
+        });
+        for (size_t i = 0; i < rules.size(); ++i)
+        {
+            if (removed[i])
+                continue;
+            activeTrees.push_back(trees[i]);
+            activeRules.push_back(rules[i]);
         }
     }
 
-    // 调度场算法转后缀
-    std::string postfix;
-    std::stack<char> opStack;
-
-    for (size_t i = 0; i < withConcat.size(); i++)
+    // 语法树 -> DFA (followpos 或导数)，不构造 NFA
+    if (!forceLazyDFA && construction == LEXER_FOLLOWPOS)
+    {
+        StatsPhase phase(stats, "lexer.followpos");
+        fits = followposToDFA(activeTrees, activeRules);
+    }
+    else if (!forceLazyDFA && construction == LEXER_DERIVATIVES)
     {
-        char c = withConcat[i];
+        StatsPhase phase(stats, "lexer.derivative");
+        fits = derivativeToDFA(activeTrees, activeRules);
+    }
 
-        if (c == '\\' && i + 1 < withConcat.size())
-        {
-            // 转义字符作为操作数
-            postfix += c;
-            postfix += withConcat[++i];
-        }
-        else if (c == '[')
-        {
-            // 字符类作为操作数
-            postfix += c;
-            while (i + 1 < withConcat.size() && withConcat[i] != ']')
-            {
-                i++;
-                postfix += withConcat[i];
-            }
-        }
-        else if (c == '(')
-        {
-            opStack.push(c);
-        }
-        else if (c == ')')
+    // Thompson NFA：子集构造的输入，也是惰性 DFA 嵌入的 NFA
+    if (!fits)
+    {
+        StatsPhase phase(stats, "lexer.nfa");
+
+        // 为每条规则构建 NFA；开头的字面串拆出来，合并时放进字典树
+        // 各规则的状态数可以从语法树算出，先按规则顺序划分编号区间，再并行构造，编号与逐条构造时相同
+        size_t count = activeTrees.size();
+        std::vector<NFA> nfas(count);
+        std::vector<std::string> prefixes(count);
+        std::vector<RegexPtr> rests(count);
+        std::vector<int> firstStateIDs(count);
+        parallelFor(count, threads, [&](size_t i) {
+            rests[i] = splitLiteralPrefix(activeTrees[i], prefixes[i]);
+            firstStateIDs[i] = thompsonStateCount(*rests[i]);
+        });
+        for (size_t i = 0; i < count; ++i)
         {
-            while (!opStack.empty() && opStack.top() != '(')
-            {
-                postfix += opStack.top();
-                opStack.pop();
-            }
-            if (!opStack.empty())
-                opStack.pop(); // 弹出 '('
+            int size = firstStateIDs[i];
+            firstStateIDs[i] = nextStateID;
+            nextStateID += size;
         }
-        else if (c == '|' || c == '.' || c == '*' || c == '+' || c == '?')
+        parallelFor(count, threads, [&](size_t i) {
+            nfas[i] = regexToNFA(*rests[i], activeRules[i].name, firstStateIDs[i]);
+        });
+
+        // 合并所有 NFA
+        mergedNFA = mergeNFAs(nfas, prefixes);
+    }
+
+    // NFA -> DFA (子集构造法)；状态数超出上限时改用惰性 DFA，由生成的词法分析器在运行时按需构造
+    // 子集构造在消除 epsilon 后的 NFA 上进行；惰性 DFA 仍嵌入原 NFA
+    size_t epsilonFreeStates = 0;
+    if (!forceLazyDFA && construction == LEXER_THOMPSON)
+    {
+        NFA epsilonFreeNFA;
         {
-            while (!opStack.empty() && opStack.top() != '(' &&
-                   getPrecedence(opStack.top()) >= getPrecedence(c))
-            {
-                postfix += opStack.top();
-                opStack.pop();
-            }
-            opStack.push(c);
+            StatsPhase phase(stats, "lexer.epsilon");
+            epsilonFreeNFA = removeEpsilons(mergedNFA);
+            epsilonFreeStates = epsilonFreeNFA.states.size();
         }
-        else
+        StatsPhase phase(stats, "lexer.subset");
+        fits = nfaToDFA(epsilonFreeNFA);
+    }
+    if (stats != nullptr)
+    {
+        stats->setCounter("keywords", (long long)keywords.size());
+    }
+
+    if (!fits)
+    {
+        StatsPhase phase(stats, "lexer.lazy");
+        dfaTable.clear();
+        buildCompactNFA(mergedNFA, activeRules);
+        lazyDFA = true;
+        if (stats != nullptr)
         {
-            // 普通字符
-            postfix += c;
+            stats->setCounter("lexRules", (long long)rules.size());
+            stats->setCounter("nfaStates", (long long)mergedNFA.states.size());
+            if (epsilonFreeStates > 0)
+                stats->setCounter("epsilonFreeNfaStates", (long long)epsilonFreeStates);
+            stats->setCounter("lazyDfa", 1);
         }
+        return;
     }
+    size_t dfaStatesBefore = dfaTable.size();
 
-    while (!opStack.empty())
+    // DFA 最小化
     {
-        postfix += opStack.top();
-        opStack.pop();
+        StatsPhase phase(stats, "lexer.minimize");
+        minimizeDFA();
     }
 
-    return postfix;
+    if (stats != nullptr)
+    {
+        stats->setCounter("lexRules", (long long)rules.size());
+        if (construction == LEXER_THOMPSON)
+        {
+            stats->setCounter("nfaStates", (long long)mergedNFA.states.size());
+            stats->setCounter("epsilonFreeNfaStates", (long long)epsilonFreeStates);
+        }
+        stats->setCounter("dfaStates", (long long)dfaStatesBefore);
+        stats->setCounter("minimizedDfaStates", (long long)dfaTable.size());
+        stats->setCounter("lazyDfa", 0);
+    }
+}
+
+const DFATable &LexerGenerator::getDFATable() const
+{
+    return dfaTable;
+}
+
+bool LexerGenerator::isLazyDFA() const
+{
+    return lazyDFA;
 }
 
-// 创建基本 NFA（匹配单个字符）
-static NFA createBasicNFA(char c, int &nextStateID)
+const CompactNFA &LexerGenerator::getCompactNFA() const
+{
+    return compactNFA;
+}
+
+const std::vector<KeywordDefinition> &LexerGenerator::getKeywords() const
+{
+    return keywords;
+}
+
+// 创建字符集 NFA（如 [a-z]、[^"]）：每个区间一条转移
+static NFA createCharSetNFA(const CharSet &chars, int &nextStateID)
 {
     NFA nfa;
     int start = nextStateID++;
@@ -262,7 +249,10 @@ static NFA createBasicNFA(char c, int &nextStateID)
     NFAState startState;
     startState.id = start;
     startState.isFinal = false;
-    startState.transitions[c].insert(end);
+    for (const auto &interval : charIntervals(chars))
+    {
+        startState.transitions.push_back(CharRange{interval.first, interval.second, end});
+    }
 
     NFAState endState;
     endState.id = end;
@@ -274,8 +264,8 @@ static NFA createBasicNFA(char c, int &nextStateID)
     return nfa;
 }
 
-// 创建字符类 NFA（如 [a-z]）
-static NFA createCharClassNFA(const std::string &charClass, int &nextStateID)
+// 创建空串 NFA
+static NFA createEmptyNFA(int &nextStateID)
 {
     NFA nfa;
     int start = nextStateID++;
@@ -287,46 +277,7 @@ static NFA createCharClassNFA(const std::string &charClass, int &nextStateID)
     NFAState startState;
     startState.id = start;
     startState.isFinal = false;
-
-    // 解析字符类
-    std::set<char> chars;
-    for (size_t i = 0; i < charClass.size(); i++)
-    {
-        if (i + 2 < charClass.size() && charClass[i + 1] == '-')
-        {
-            // 范围 a-z
-            char from = charClass[i];
-            char to = charClass[i + 2];
-            for (char c = from; c <= to; c++)
-            {
-                chars.insert(c);
-            }
-            i += 2;
-        }
-        else if (charClass[i] == '\\' && i + 1 < charClass.size())
-        {
-            // 转义字符
-            char next = charClass[i + 1];
-            if (next == 't')
-                chars.insert('\t');
-            else if (next == 'n')
-                chars.insert('\n');
-            else if (next == 'r')
-                chars.insert('\r');
-            else
-                chars.insert(next);
-            i++;
-        }
-        else
-        {
-            chars.insert(charClass[i]);
-        }
-    }
-
-    for (char c : chars)
-    {
-        startState.transitions[c].insert(end);
-    }
+    startState.epsilonTransitions.insert(end);
 
     NFAState endState;
     endState.id = end;
@@ -523,115 +474,88 @@ static NFA optionalNFA(NFA &nfa, int &nextStateID)
     return result;
 }
 
-NFA LexerGenerator::regexToNFA(const std::string &regex, const std::string &tokenName)
-{
-    std::string postfix = regexToPostfix(regex);
-    std::stack<NFA> nfaStack;
+static NFA treeToNFA(const RegexNode &node, int &nextStateID);
 
-    for (size_t i = 0; i < postfix.size(); i++)
+// 依次连接 / 并联 children (左结合)
+static NFA combineNFA(const RegexNode &node, int &nextStateID)
+{
+    NFA result = treeToNFA(*node.children[0], nextStateID);
+    for (size_t i = 1; i < node.children.size(); i++)
     {
-        char c = postfix[i];
-
-        if (c == '\\' && i + 1 < postfix.size())
-        {
-            // 转义字符
-            char next = postfix[++i];
-            char actual;
-            if (next == 't')
-                actual = '\t';
-            else if (next == 'n')
-                actual = '\n';
-            else if (next == 'r')
-                actual = '\r';
-            else
-                actual = next;
-
-            nfaStack.push(createBasicNFA(actual, nextStateID));
-        }
-        else if (c == '[')
-        {
-            // 字符类
-            std::string charClass;
-            i++; // 跳过 '['
-            while (i < postfix.size() && postfix[i] != ']')
-            {
-                charClass += postfix[i];
-                i++;
-            }
-            nfaStack.push(createCharClassNFA(charClass, nextStateID));
-        }
-        else if (c == '.')
-        {
-            // 连接
-            if (nfaStack.size() < 2)
-                continue;
-            NFA nfa2 = nfaStack.top();
-            nfaStack.pop();
-            NFA nfa1 = nfaStack.top();
-            nfaStack.pop();
-            nfaStack.push(concatenateNFA(nfa1, nfa2));
-        }
-        else if (c == '|')
-        {
-            // 并联
-            if (nfaStack.size() < 2)
-                continue;
-            NFA nfa2 = nfaStack.top();
-            nfaStack.pop();
-            NFA nfa1 = nfaStack.top();
-            nfaStack.pop();
-            nfaStack.push(alternateNFA(nfa1, nfa2, nextStateID));
-        }
-        else if (c == '*')
-        {
-            // 闭包
-            if (nfaStack.empty())
-                continue;
-            NFA nfa = nfaStack.top();
-            nfaStack.pop();
-            nfaStack.push(kleeneStarNFA(nfa, nextStateID));
-        }
-        else if (c == '+')
-        {
-            // 正闭包
-            if (nfaStack.empty())
-                continue;
-            NFA nfa = nfaStack.top();
-            nfaStack.pop();
-            nfaStack.push(plusClosureNFA(nfa, nextStateID));
-        }
-        else if (c == '?')
-        {
-            // 可选
-            if (nfaStack.empty())
-                continue;
-            NFA nfa = nfaStack.top();
-            nfaStack.pop();
-            nfaStack.push(optionalNFA(nfa, nextStateID));
-        }
+        NFA next = treeToNFA(*node.children[i], nextStateID);
+        if (node.kind == RegexNode::CONCAT)
+            result = concatenateNFA(result, next);
         else
-        {
-            // 普通字符
-            nfaStack.push(createBasicNFA(c, nextStateID));
-        }
+            result = alternateNFA(result, next, nextStateID);
     }
+    return result;
+}
 
-    NFA result;
-    if (!nfaStack.empty())
+static NFA treeToNFA(const RegexNode &node, int &nextStateID)
+{
+    switch (node.kind)
+    {
+    case RegexNode::EMPTY:
+        return createEmptyNFA(nextStateID);
+    case RegexNode::CHARSET:
+        return createCharSetNFA(node.chars, nextStateID);
+    case RegexNode::CONCAT:
+    case RegexNode::ALTERNATE:
+        return combineNFA(node, nextStateID);
+    case RegexNode::STAR:
+    {
+        NFA nfa = treeToNFA(*node.children[0], nextStateID);
+        return kleeneStarNFA(nfa, nextStateID);
+    }
+    case RegexNode::PLUS:
+    {
+        NFA nfa = treeToNFA(*node.children[0], nextStateID);
+        return plusClosureNFA(nfa, nextStateID);
+    }
+    case RegexNode::OPTIONAL:
+    {
+        NFA nfa = treeToNFA(*node.children[0], nextStateID);
+        return optionalNFA(nfa, nextStateID);
+    }
+    }
+    return createEmptyNFA(nextStateID);
+}
+
+// treeToNFA 分配的状态数：连接不新增状态，其余每个构造新增 2 个 (n 路并联为 n - 1 次两两并联)
+int LexerGenerator::thompsonStateCount(const RegexNode &tree)
+{
+    switch (tree.kind)
     {
-        result = nfaStack.top();
-        // 设置终态的 token 名称
-        result.states[result.endState].tokenName = tokenName;
+    case RegexNode::CONCAT:
+    case RegexNode::ALTERNATE:
+    {
+        int count = tree.kind == RegexNode::ALTERNATE ? 2 * ((int)tree.children.size() - 1) : 0;
+        for (const auto &child : tree.children)
+            count += thompsonStateCount(*child);
+        return count;
     }
+    case RegexNode::STAR:
+    case RegexNode::PLUS:
+    case RegexNode::OPTIONAL:
+        return thompsonStateCount(*tree.children[0]) + 2;
+    default:
+        return 2;
+    }
+}
 
+NFA LexerGenerator::regexToNFA(const RegexNode &tree, const std::string &tokenName, int firstStateID)
+{
+    NFA result = treeToNFA(tree, firstStateID);
+    // 设置终态的 token 名称
+    result.states[result.endState].tokenName = tokenName;
     return result;
 }
 
-NFA LexerGenerator::mergeNFAs(const std::vector<NFA> &nfas)
+NFA LexerGenerator::mergeNFAs(const std::vector<NFA> &nfas, const std::vector<std::string> &prefixes)
 {
     if (nfas.empty())
         return NFA();
-    if (nfas.size() == 1)
+    if (nfas.size() == 1 && prefixes[0].empty())
         return nfas[0];
 
     NFA result;
@@ -642,27 +566,116 @@ NFA LexerGenerator::mergeNFAs(const std::vector<NFA> &nfas)
     NFAState startState;
     startState.id = newStart;
     startState.isFinal = false;
+    result.states[newStart] = startState;
 
-    // 新起始状态通过 epsilon 连接到所有 NFA 的起始状态
-    for (const auto &nfa : nfas)
+    // 字典树：(节点, 字符) -> 子节点，根为新起始状态
+    std::map<std::pair<int, unsigned char>, int> trie;
+    for (size_t i = 0; i < nfas.size(); i++)
     {
-        startState.epsilonTransitions.insert(nfa.startState);
+        int node = newStart;
+        for (char ch : prefixes[i])
+        {
+            std::pair<int, unsigned char> key(node, (unsigned char)ch);
+            auto it = trie.find(key);
+            if (it == trie.end())
+            {
+                NFAState child;
+                child.id = nextStateID++;
+                child.isFinal = false;
+                result.states[child.id] = child;
+                result.states[node].transitions.push_back(CharRange{key.second, key.second, child.id});
+                it = trie.insert(std::make_pair(key, child.id)).first;
+            }
+            node = it->second;
+        }
+
+        // 前缀走完的节点通过 epsilon 连接到该规则剩余部分的 NFA
+        result.states[node].epsilonTransitions.insert(nfas[i].startState);
 
         // 复制所有状态
-        for (const auto &p : nfa.states)
+        for (const auto &p : nfas[i].states)
         {
             result.states[p.first] = p.second;
         }
     }
 
-    result.states[newStart] = startState;
-
     // 合并后没有单一终态，多个终态保留各自的 tokenName
     result.endState = -1;
 
     return result;
 }
 
+// Token 优先级：规则定义顺序靠前的优先 (同名规则取第一次出现的位置)
+static std::map<std::string, size_t> rulePriority(const std::vector<TokenDefinition> &rules)
+{
+    std::map<std::string, size_t> priority;
+    for (size_t i = 0; i < rules.size(); ++i)
+    {
+        priority.insert(std::make_pair(rules[i].name, i));
+    }
+    return priority;
+}
+
+NFA LexerGenerator::removeEpsilons(const NFA &nfa)
+{
+    std::map<std::string, size_t> priority = rulePriority(rules);
+
+    // 保留的状态：起始状态与所有字符转移的目标
+    std::set<int> keptSet;
+    keptSet.insert(nfa.startState);
+    for (const auto &p : nfa.states)
+    {
+        for (const auto &range : p.second.transitions)
+            keptSet.insert(range.target);
+    }
+    std::vector<int> kept(keptSet.begin(), keptSet.end());
+
+    // 各状态的闭包互不依赖，并行计算
+    std::vector<NFAState> states(kept.size());
+    parallelFor(kept.size(), threads, [&](size_t i) {
+        NFAState &state = states[i];
+        state.id = kept[i];
+        state.isFinal = false;
+        size_t best = rules.size();
+        for (int s : epsilonClosure(nfa, {kept[i]}))
+        {
+            auto it = nfa.states.find(s);
+            if (it == nfa.states.end())
+                continue;
+            state.transitions.insert(state.transitions.end(), it->second.transitions.begin(), it->second.transitions.end());
+            if (!it->second.isFinal)
+                continue;
+            auto rank = priority.find(it->second.tokenName);
+            if (rank != priority.end() && rank->second < best)
+            {
+                best = rank->second;
+                state.isFinal = true;
+                state.tokenName = it->second.tokenName;
+            }
+        }
+        std::sort(state.transitions.begin(), state.transitions.end(), [](const CharRange &a, const CharRange &b) {
+            if (a.low != b.low)
+                return a.low < b.low;
+            if (a.high != b.high)
+                return a.high < b.high;
+            return a.target < b.target;
+        });
+        state.transitions.erase(std::unique(state.transitions.begin(), state.transitions.end(), [](const CharRange &a, const CharRange &b) {
+            return a.low == b.low && a.high == b.high && a.target == b.target;
+        }), state.transitions.end());
+    });
+
+    NFA result;
+    result.startState = nfa.startState;
+    result.endState = -1;
+    for (auto &state : states)
+    {
+        int id = state.id;
+        result.states[id] = std::move(state);
+    }
+    return result;
+}
+
 std::set<int> LexerGenerator::epsilonClosure(const NFA &nfa, const std::set<int> &states)
 {
     std::set<int> closure = states;
@@ -695,7 +708,7 @@ std::set<int> LexerGenerator::epsilonClosure(const NFA &nfa, const std::set<int>
     return closure;
 }
 
-std::set<int> LexerGenerator::move(const NFA &nfa, const std::set<int> &states, char c)
+std::set<int> LexerGenerator::move(const NFA &nfa, const std::set<int> &states, unsigned char c)
 {
     std::set<int> result;
 
@@ -704,12 +717,11 @@ std::set<int> LexerGenerator::move(const NFA &nfa, const std::set<int> &states,
         auto it = nfa.states.find(state);
         if (it != nfa.states.end())
         {
-            auto transIt = it->second.transitions.find(c);
-            if (transIt != it->second.transitions.end())
+            for (const auto &range : it->second.transitions)
             {
-                for (int next : transIt->second)
+                if (range.low <= c && c <= range.high)
                 {
-                    result.insert(next);
+                    result.insert(range.target);
                 }
             }
         }
@@ -718,22 +730,105 @@ std::set<int> LexerGenerator::move(const NFA &nfa, const std::set<int> &states,
     return result;
 }
 
-void LexerGenerator::nfaToDFA(const NFA &nfa)
+// 把可能重叠的转移区间按端点切成基本区间：同一基本区间内的字符被同一组区间覆盖，取起点即可代表整段
+// 返回相邻端点之间的各段 (按 low 升序)，其中可能有不被任何区间覆盖的空隙
+static CharIntervals splitRanges(const std::vector<CharRange> &ranges)
 {
-    std::map<int, DFASubset> dfaStates;
-    std::map<std::set<int>, int> stateSetToID;
-    std::queue<std::set<int>> worklist;
-    int dfaStateCounter = 0;
+    std::vector<unsigned int> bounds;
+    for (const auto &range : ranges)
+    {
+        bounds.push_back(range.low);
+        bounds.push_back(range.high + 1u);
+    }
+    std::sort(bounds.begin(), bounds.end());
+    bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
 
-    // 收集所有输入字符
-    std::set<char> alphabet;
-    for (const auto &p : nfa.states)
+    CharIntervals result;
+    for (size_t i = 0; i + 1 < bounds.size(); i++)
     {
-        for (const auto &t : p.second.transitions)
+        result.push_back(std::make_pair((unsigned char)bounds[i], (unsigned char)(bounds[i + 1] - 1)));
+    }
+    return result;
+}
+
+// 在按 low 升序构造的转移末尾追加一段；与上一段相邻且目标相同时合并
+static void appendTransition(std::vector<CharRange> &transitions, unsigned char low, unsigned char high, int target)
+{
+    if (!transitions.empty() && transitions.back().target == target && transitions.back().high + 1 == low)
+    {
+        transitions.back().high = high;
+    }
+    else
+    {
+        transitions.push_back(CharRange{low, high, target});
+    }
+}
+
+bool LexerGenerator::literalText(const RegexPtr &tree, std::string &text)
+{
+    return splitLiteralPrefix(tree, text)->kind == RegexNode::EMPTY && !text.empty();
+}
+
+// 字面串规则 i 被移出 DFA 的条件：
+// - 前面没有规则能匹配它 (否则它本来就识别不到，保持原样)
+// - 后面第一条能匹配它的规则不是字面串 (即标识符一类的规则)，也不是 SKIP
+// 满足时去掉规则 i 不改变 DFA 接受的串，只是该串的 Token 从 i 变成覆盖规则，按词素改判回来即可
+std::vector<bool> LexerGenerator::extractKeywords(const std::vector<RegexPtr> &trees, const std::function<bool(size_t, const std::string &)> &accepts)
+{
+    keywords.clear();
+    std::vector<bool> removed(rules.size(), false);
+    if (!keywordHashing)
+        return removed;
+
+    std::vector<std::string> literals(rules.size());
+    std::vector<bool> isLiteral(rules.size(), false);
+    for (size_t i = 0; i < rules.size(); ++i)
+    {
+        isLiteral[i] = literalText(trees[i], literals[i]);
+    }
+
+    for (size_t i = 0; i < rules.size(); ++i)
+    {
+        if (!isLiteral[i] || rules[i].name == "SKIP")
+            continue;
+
+        // 字面串之间直接比较，其余规则在各自的位置自动机上模拟
+        auto matches = [&](size_t j) {
+            return isLiteral[j] ? literals[j] == literals[i] : accepts(j, literals[i]);
+        };
+
+        bool shadowed = false;
+        for (size_t j = 0; j < i && !shadowed; ++j)
         {
-            alphabet.insert(t.first);
+            shadowed = matches(j);
+        }
+        if (shadowed)
+            continue;
+
+        for (size_t j = i + 1; j < rules.size(); ++j)
+        {
+            if (!matches(j))
+                continue;
+            if (!isLiteral[j] && rules[j].name != "SKIP")
+            {
+                KeywordDefinition keyword;
+                keyword.name = rules[i].name;
+                keyword.text = literals[i];
+                keyword.coverName = rules[j].name;
+                keywords.push_back(keyword);
+                removed[i] = true;
+            }
+            break;
         }
     }
+    return removed;
+}
+
+bool LexerGenerator::nfaToDFA(const NFA &nfa)
+{
+    std::map<int, DFASubset> dfaStates;
+    std::map<std::set<int>, int> stateSetToID;
+    int dfaStateCounter = 0;
 
     // 初始状态：起始状态的 epsilon 闭包
     std::set<int> startSet = epsilonClosure(nfa, {nfa.startState});
@@ -765,69 +860,397 @@ void LexerGenerator::nfaToDFA(const NFA &nfa)
     }
 
     dfaStates[startSubset.dfaStateID] = startSubset;
-    worklist.push(startSet);
 
-    while (!worklist.empty())
+    // 新状态的 Token：规则定义顺序靠前的优先
+    std::map<std::string, size_t> priority = rulePriority(rules);
+
+    // 一个状态在某个基本区间上的转移；target < 0 表示目标集合在本层开始时还没有编号
+    struct SubsetMove
     {
-        std::set<int> currentSet = worklist.front();
-        worklist.pop();
+        unsigned char low, high;
+        std::set<int> nfaStates;
+        int target;
+        bool isFinal;
+        std::string tokenName;
+    };
+
+    // 逐层处理：frontier 为上一层新发现的状态，按发现顺序排列
+    std::vector<int> frontier(1, startSubset.dfaStateID);
+    while (!frontier.empty())
+    {
+        // 并行：move、epsilon 闭包与终态判断；stateSetToID 与 dfaStates 在本阶段只读
+        std::vector<std::vector<SubsetMove>> moves(frontier.size());
+        parallelFor(frontier.size(), threads, [&](size_t f) {
+            const std::set<int> &currentSet = dfaStates.find(frontier[f])->second.nfaStates;
+
+            // 本状态上所有 NFA 转移区间切成的基本区间
+            std::vector<CharRange> ranges;
+            for (int s : currentSet)
+            {
+                auto it = nfa.states.find(s);
+                if (it != nfa.states.end())
+                    ranges.insert(ranges.end(), it->second.transitions.begin(), it->second.transitions.end());
+            }
 
-        int currentDFAState = stateSetToID[currentSet];
+            for (const auto &interval : splitRanges(ranges))
+            {
+                SubsetMove next;
+                next.nfaStates = epsilonClosure(nfa, move(nfa, currentSet, interval.first));
+                if (next.nfaStates.empty())
+                    continue;
+                next.low = interval.first;
+                next.high = interval.second;
+                next.isFinal = false;
+
+                auto known = stateSetToID.find(next.nfaStates);
+                next.target = known != stateSetToID.end() ? known->second : -1;
+                if (next.target < 0)
+                {
+                    // 检查终态，按规则优先级选择
+                    size_t best = rules.size();
+                    for (int s : next.nfaStates)
+                    {
+                        auto it = nfa.states.find(s);
+                        if (it == nfa.states.end() || !it->second.isFinal)
+                            continue;
+                        auto rank = priority.find(it->second.tokenName);
+                        if (rank != priority.end() && rank->second < best)
+                        {
+                            best = rank->second;
+                            next.isFinal = true;
+                            next.tokenName = it->second.tokenName;
+                        }
+                    }
+                }
+                moves[f].push_back(std::move(next));
+            }
+        });
 
-        for (char c : alphabet)
+        // 串行：按层内顺序、区间顺序给新集合编号，与逐个出队的 BFS 编号一致，结果不随线程数变化
+        std::vector<int> nextFrontier;
+        for (size_t f = 0; f < frontier.size(); ++f)
         {
-            std::set<int> nextSet = epsilonClosure(nfa, move(nfa, currentSet, c));
-
-            if (nextSet.empty())
-                continue;
-
-            int nextDFAState;
-            if (stateSetToID.find(nextSet) == stateSetToID.end())
+            for (auto &next : moves[f])
             {
-                // 新状态
-                nextDFAState = dfaStateCounter++;
-                stateSetToID[nextSet] = nextDFAState;
-
-                DFASubset newSubset;
-                newSubset.nfaStates = nextSet;
-                newSubset.dfaStateID = nextDFAState;
-                newSubset.isFinal = false;
-                newSubset.tokenName = "";
-
-                // 检查终态，按规则优先级选择
-                for (const auto &rule : rules)
+                int nextDFAState = next.target;
+                if (nextDFAState < 0)
                 {
-                    for (int s : nextSet)
+                    auto known = stateSetToID.find(next.nfaStates);
+                    if (known != stateSetToID.end())
                     {
-                        auto it = nfa.states.find(s);
-                        if (it != nfa.states.end() && it->second.isFinal &&
-                            it->second.tokenName == rule.name)
+                        // 同一层中已由前面的状态发现
+                        nextDFAState = known->second;
+                    }
+                    else
+                    {
+                        // 新状态
+                        if (dfaStateBudget > 0 && (size_t)dfaStateCounter >= dfaStateBudget)
                         {
-                            newSubset.isFinal = true;
-                            if (newSubset.tokenName.empty())
-                            {
-                                newSubset.tokenName = it->second.tokenName;
-                            }
-                            break;
+                            return false;
                         }
+                        nextDFAState = dfaStateCounter++;
+                        stateSetToID[next.nfaStates] = nextDFAState;
+
+                        DFASubset newSubset;
+                        newSubset.dfaStateID = nextDFAState;
+                        newSubset.isFinal = next.isFinal;
+                        newSubset.tokenName = next.tokenName;
+                        newSubset.nfaStates = std::move(next.nfaStates);
+                        dfaStates[nextDFAState] = std::move(newSubset);
+                        nextFrontier.push_back(nextDFAState);
                     }
-                    if (!newSubset.tokenName.empty())
-                        break;
                 }
 
-                dfaStates[nextDFAState] = newSubset;
-                worklist.push(nextSet);
+                appendTransition(dfaStates[frontier[f]].transitions, next.low, next.high, nextDFAState);
+            }
+        }
+        frontier.swap(nextFrontier);
+    }
+
+    convertToDFATable(dfaStates);
+    return true;
+}
+
+bool LexerGenerator::followposToDFA(const std::vector<RegexPtr> &trees, const std::vector<TokenDefinition> &activeRules)
+{
+    // 规则优先级与子集构造一致：按名字第一次出现的顺序
+    std::map<std::string, int> firstIndex;
+    PositionAutomaton automaton;
+    for (size_t i = 0; i < trees.size(); ++i)
+    {
+        auto it = firstIndex.insert(std::make_pair(activeRules[i].name, (int)i)).first;
+        automaton.addRule(trees[i], it->second);
+    }
+    automaton.finish();
+    if (stats != nullptr)
+    {
+        stats->setCounter("positions", (long long)automaton.positionCount());
+    }
+
+    std::map<int, DFASubset> dfaStates;
+    std::map<std::vector<int>, int> stateSetToID;
+    std::queue<std::vector<int>> worklist;
+    int dfaStateCounter = 0;
+
+    // 位置集合中优先级最高的结束标记决定 Token
+    auto addState = [&](const std::vector<int> &positions) {
+        DFASubset subset;
+        subset.nfaStates = std::set<int>(positions.begin(), positions.end());
+        subset.dfaStateID = dfaStateCounter++;
+        subset.isFinal = false;
+        int best = -1;
+        for (int p : positions)
+        {
+            int accept = automaton.accept(p);
+            if (accept >= 0 && (best < 0 || accept < best))
+                best = accept;
+        }
+        if (best >= 0)
+        {
+            subset.isFinal = true;
+            subset.tokenName = activeRules[best].name;
+        }
+        stateSetToID[positions] = subset.dfaStateID;
+        dfaStates[subset.dfaStateID] = subset;
+        worklist.push(positions);
+        return subset.dfaStateID;
+    };
+
+    addState(automaton.start());
+    while (!worklist.empty())
+    {
+        std::vector<int> current = worklist.front();
+        worklist.pop();
+        int currentID = stateSetToID[current];
+
+        // 各位置的字符区间切成基本区间，按段汇总 followpos
+        std::vector<CharRange> ranges;
+        for (int p : current)
+        {
+            for (const auto &interval : automaton.chars(p))
+            {
+                ranges.push_back(CharRange{interval.first, interval.second, p});
+            }
+        }
+
+        for (const auto &interval : splitRanges(ranges))
+        {
+            std::vector<int> next;
+            for (const auto &range : ranges)
+            {
+                if (range.low <= interval.first && interval.first <= range.high)
+                    next.insert(next.end(), automaton.follow(range.target).begin(), automaton.follow(range.target).end());
+            }
+            if (next.empty())
+                continue;
+            std::sort(next.begin(), next.end());
+            next.erase(std::unique(next.begin(), next.end()), next.end());
+
+            int nextID;
+            auto it = stateSetToID.find(next);
+            if (it != stateSetToID.end())
+            {
+                nextID = it->second;
+            }
+            else
+            {
+                if (dfaStateBudget > 0 && (size_t)dfaStateCounter >= dfaStateBudget)
+                {
+                    return false;
+                }
+                nextID = addState(next);
+            }
+            appendTransition(dfaStates[currentID].transitions, interval.first, interval.second, nextID);
+        }
+    }
+
+    convertToDFATable(dfaStates);
+    return true;
+}
+
+bool LexerGenerator::derivativeToDFA(const std::vector<RegexPtr> &trees, const std::vector<TokenDefinition> &activeRules)
+{
+    // 规则优先级与子集构造一致：按名字第一次出现的顺序
+    std::map<std::string, int> firstIndex;
+    std::vector<int> priority;
+    for (size_t i = 0; i < activeRules.size(); ++i)
+    {
+        auto it = firstIndex.insert(std::make_pair(activeRules[i].name, (int)i)).first;
+        priority.push_back(it->second);
+    }
+
+    // DFA 状态：每条规则各自的剩余正则；化简后相似的项编号相同，状态数因此有限
+    DerivativeTerms terms;
+    std::vector<int> start;
+    for (const auto &tree : trees)
+    {
+        start.push_back(terms.fromTree(*tree));
+    }
+
+    std::map<int, DFASubset> dfaStates;
+    std::map<std::vector<int>, int> stateSetToID;
+    std::queue<std::vector<int>> worklist;
+    int dfaStateCounter = 0;
+
+    // 可以接受空串的剩余正则中优先级最高者决定 Token
+    auto addState = [&](const std::vector<int> &state) {
+        DFASubset subset;
+        subset.dfaStateID = dfaStateCounter++;
+        subset.isFinal = false;
+        int best = -1;
+        for (size_t i = 0; i < state.size(); ++i)
+        {
+            if (terms.nullable(state[i]) && (best < 0 || priority[i] < best))
+                best = priority[i];
+        }
+        if (best >= 0)
+        {
+            subset.isFinal = true;
+            subset.tokenName = activeRules[best].name;
+        }
+        stateSetToID[state] = subset.dfaStateID;
+        dfaStates[subset.dfaStateID] = subset;
+        worklist.push(state);
+        return subset.dfaStateID;
+    };
+
+    addState(start);
+    while (!worklist.empty())
+    {
+        std::vector<int> current = worklist.front();
+        worklist.pop();
+        int currentID = stateSetToID[current];
+
+        // 各规则导数类的交：同一类中的字符转移到同一状态，每类只求一次导数
+        std::vector<CharSet> classes(1, CharSet().set());
+        for (int term : current)
+        {
+            if (term == terms.nothing())
+                continue;
+            std::vector<CharSet> refined;
+            for (const auto &a : classes)
+            {
+                for (const auto &b : terms.classes(term))
+                {
+                    CharSet both = a & b;
+                    if (both.any())
+                        refined.push_back(both);
+                }
+            }
+            classes.swap(refined);
+        }
+
+        // 按类中最小的字符排序，新状态的编号顺序与逐字符构造一致
+        std::map<unsigned int, CharSet> ordered;
+        for (const auto &chars : classes)
+        {
+            unsigned int first = 0;
+            while (!chars.test(first))
+                ++first;
+            ordered[first] = chars;
+        }
+
+        std::vector<CharRange> moves;
+        for (const auto &entry : ordered)
+        {
+            unsigned int first = entry.first;
+            const CharSet &chars = entry.second;
+
+            std::vector<int> next;
+            bool dead = true;
+            for (int term : current)
+            {
+                next.push_back(terms.derive(term, (unsigned char)first));
+                dead = dead && next.back() == terms.nothing();
+            }
+            if (dead)
+                continue;
+
+            int nextID;
+            auto it = stateSetToID.find(next);
+            if (it != stateSetToID.end())
+            {
+                nextID = it->second;
             }
             else
             {
-                nextDFAState = stateSetToID[nextSet];
+                if (dfaStateBudget > 0 && (size_t)dfaStateCounter >= dfaStateBudget)
+                {
+                    return false;
+                }
+                nextID = addState(next);
+            }
+            for (const auto &interval : charIntervals(chars))
+            {
+                moves.push_back(CharRange{interval.first, interval.second, nextID});
             }
+        }
 
-            dfaStates[currentDFAState].transitions[c] = nextDFAState;
+        // 不同类的区间交错排列，按 low 排好再合并
+        std::sort(moves.begin(), moves.end(), [](const CharRange &a, const CharRange &b) { return a.low < b.low; });
+        for (const auto &range : moves)
+        {
+            appendTransition(dfaStates[currentID].transitions, range.low, range.high, range.target);
         }
     }
 
+    if (stats != nullptr)
+    {
+        stats->setCounter("derivativeTerms", (long long)terms.termCount());
+    }
     convertToDFATable(dfaStates);
+    return true;
+}
+
+void LexerGenerator::buildCompactNFA(const NFA &nfa, const std::vector<TokenDefinition> &activeRules)
+{
+    compactNFA = CompactNFA();
+
+    // 规则优先级：按定义顺序，同名规则取第一次出现
+    std::map<std::string, int> priority;
+    for (const auto &rule : activeRules)
+    {
+        if (priority.count(rule.name) == 0)
+        {
+            priority[rule.name] = (int)compactNFA.tokenNames.size();
+            compactNFA.tokenNames.push_back(rule.name);
+        }
+    }
+
+    // NFA 状态 ID 不连续，按顺序重新编号
+    std::map<int, int> index;
+    for (const auto &p : nfa.states)
+    {
+        int id = (int)index.size();
+        index[p.first] = id;
+    }
+
+    size_t count = index.size();
+    compactNFA.startState = index[nfa.startState];
+    compactNFA.accept.assign(count, -1);
+    compactNFA.epsilon.resize(count);
+    compactNFA.transitions.resize(count);
+    for (const auto &p : nfa.states)
+    {
+        int id = index[p.first];
+        const NFAState &state = p.second;
+        if (state.isFinal)
+        {
+            auto it = priority.find(state.tokenName);
+            if (it != priority.end())
+            {
+                compactNFA.accept[id] = it->second;
+            }
+        }
+        for (int next : state.epsilonTransitions)
+        {
+            compactNFA.epsilon[id].push_back(index[next]);
+        }
+        for (const auto &range : state.transitions)
+        {
+            compactNFA.transitions[id].push_back(CharRange{range.low, range.high, index[range.target]});
+        }
+    }
 }
 
 void LexerGenerator::minimizeDFA()
@@ -836,15 +1259,13 @@ void LexerGenerator::minimizeDFA()
     if (dfaTable.empty())
         return;
 
-    // 收集所有字符
-    std::set<char> alphabet;
+    // 所有转移区间切成基本区间，每段取起点作为代表字符
+    std::vector<CharRange> allRanges;
     for (const auto &row : dfaTable)
     {
-        for (const auto &t : row.transitions)
-        {
-            alphabet.insert(t.first);
-        }
+        allRanges.insert(allRanges.end(), row.transitions.begin(), row.transitions.end());
     }
+    CharIntervals alphabet = splitRanges(allRanges);
 
     // 初始划分：终态按 tokenName 分组，非终态一组
     std::map<std::string, std::set<int>> partitions;
@@ -881,6 +1302,16 @@ void LexerGenerator::minimizeDFA()
         changed = false;
         std::vector<std::set<int>> newP;
 
+        // 每个状态所在的组
+        std::vector<int> groupOf(dfaTable.size(), -1);
+        for (size_t i = 0; i < P.size(); i++)
+        {
+            for (int state : P[i])
+            {
+                groupOf[state] = (int)i;
+            }
+        }
+
         for (const auto &group : P)
         {
             if (group.size() <= 1)
@@ -895,24 +1326,11 @@ void LexerGenerator::minimizeDFA()
             for (int state : group)
             {
                 std::vector<int> signature;
-                for (char c : alphabet)
+                for (const auto &interval : alphabet)
                 {
-                    int target = -1;
-                    auto it = dfaTable[state].transitions.find(c);
-                    if (it != dfaTable[state].transitions.end())
-                    {
-                        int targetState = it->second;
-                        // 找目标所在的组
-                        for (size_t i = 0; i < P.size(); i++)
-                        {
-                            if (P[i].find(targetState) != P[i].end())
-                            {
-                                target = (int)i;
-                                break;
-                            }
-                        }
-                    }
-                    signature.push_back(target);
+                    // 目标所在的组，没有转移为 -1
+                    int targetState = findTransition(dfaTable[state].transitions, interval.first);
+                    signature.push_back(targetState >= 0 ? groupOf[targetState] : -1);
                 }
                 subgroups[signature].insert(state);
             }
@@ -937,6 +1355,16 @@ void LexerGenerator::minimizeDFA()
         return; // 无法进一步最小化
     }
 
+    // 生成的词法分析器从状态 0 开始，起始状态所在的组必须编号为 0
+    for (size_t i = 0; i < P.size(); i++)
+    {
+        if (P[i].count(0))
+        {
+            std::swap(P[0], P[i]);
+            break;
+        }
+    }
+
     std::map<int, int> oldToNew;
     for (size_t i = 0; i < P.size(); i++)
     {
@@ -957,7 +1385,7 @@ void LexerGenerator::minimizeDFA()
 
         for (const auto &t : dfaTable[representative].transitions)
         {
-            newRow.transitions[t.first] = oldToNew[t.second];
+            appendTransition(newRow.transitions, t.low, t.high, oldToNew[t.target]);
         }
 
         newTable.push_back(newRow);
@@ -989,7 +1417,7 @@ void LexerGenerator::convertToDFATable(const std::map<int, DFASubset> &dfaStates
 
         for (const auto &t : p.second.transitions)
         {
-            dfaTable[idx].transitions[t.first] = idMap[t.second];
+            appendTransition(dfaTable[idx].transitions, t.low, t.high, idMap[t.target]);
         }
     }
 }
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "Types.h"
+#include "RegexAST.h"
+#include "RegexDerivative.h"
 #include <set>
 #include <map>
+#include <functional>
 
 // NFA 状态结构
 struct NFAState
@@ -10,7 +13,7 @@ struct NFAState
     int id;
     bool isFinal;
     std::string tokenName;                     // 如果是终态，对应的Token名字
-    std::map<char, std::set<int>> transitions; // 字符 -> 目标状态集合
+    std::vector<CharRange> transitions;        // 字符区间 -> 目标状态 (区间之间可以重叠)
     std::set<int> epsilonTransitions;          // epsilon 转换
 };
 
@@ -29,7 +32,16 @@ struct DFASubset
     bool isFinal;
     std::string tokenName; // 如果有多个终态，选择优先级最高的
     int dfaStateID;
-    std::map<char, int> transitions; // 字符 -> 目标DFA状态ID
+    std::vector<CharRange> transitions; // 字符区间 -> 目标DFA状态ID (按 low 升序)
+};
+
+class GeneratorStats;
+
+// DFA 的构造方法
+enum LexerConstruction {
+    LEXER_THOMPSON,  // 正则 -> 后缀式 -> Thompson NFA -> 子集构造
+    LEXER_FOLLOWPOS, // 正则 -> 语法树 -> followpos 直接构造 DFA (不经过 NFA)
+    LEXER_DERIVATIVES, // 正则 -> 语法树 -> Brzozowski 导数构造 DFA (不经过 NFA)
 };
 
 class LexerGenerator
@@ -38,6 +50,9 @@ public:
     // 初始化
     LexerGenerator();
 
+    // 可选：记录构建各阶段的耗时与规模 (--stats)
+    void setStats(GeneratorStats *stats);
+
     // 1. 添加一条词法规则
     // 例如: AddRule("NUM", "[0-9]+")
     void addRule(const std::string &tokenName, const std::string &regex);
@@ -49,38 +64,91 @@ public:
     // 3. 获取生成的 DFA 表 (供成员 C 使用)
     const DFATable &getDFATable() const;
 
+    // 子集构造的 DFA 状态上限 (0 表示不限制)；超出时放弃完整 DFA，改为惰性 DFA 模式
+    static const size_t DEFAULT_DFA_STATE_BUDGET = 10000;
+    void setDFAStateBudget(size_t maxStates);
+    // 不构造 DFA，直接使用惰性 DFA 模式
+    void setForceLazyDFA(bool force);
+
+    // 惰性 DFA 模式：此时 getDFATable() 为空，词法分析器由 getCompactNFA() 生成
+    bool isLazyDFA() const;
+    const CompactNFA &getCompactNFA() const;
+
+    // DFA 构造方法 (默认 LEXER_THOMPSON)；惰性 DFA 模式总是使用 Thompson NFA
+    void setConstruction(LexerConstruction construction);
+
+    // Thompson 路径的工作线程数 (默认 1，0 表示硬件线程数)：各规则的 NFA 并行构造，子集构造按 BFS 层并行
+    // 状态编号与单线程完全相同，生成的词法分析器不随线程数变化
+    void setThreads(unsigned int threads);
+
+    // 关键字识别 (默认开启)：被标识符规则覆盖的字面串规则不进入 DFA，由 getKeywords() 交给生成器做完美哈希
+    void setKeywordHashing(bool enable);
+    const std::vector<KeywordDefinition> &getKeywords() const;
+
 private:
     std::vector<TokenDefinition> rules;
     DFATable dfaTable;
 
     int nextStateID; // 用于生成唯一的状态ID
 
-    // ========== 核心算法实现 ==========
+    GeneratorStats *stats; // 可为空
 
-    // 1. 正则表达式预处理：将字符类展开，转义字符处理
-    std::string preprocessRegex(const std::string &regex);
+    size_t dfaStateBudget;
+    bool forceLazyDFA;
+    bool lazyDFA;
+    CompactNFA compactNFA;
 
-    // 2. 将正则表达式转换为后缀表达式（支持基本操作符）
-    std::string regexToPostfix(const std::string &regex);
+    bool keywordHashing;
+    std::vector<KeywordDefinition> keywords;
 
-    // 3. Thompson算法：正则表达式 -> NFA
-    NFA regexToNFA(const std::string &regex, const std::string &tokenName);
+    LexerConstruction construction;
 
-    // 4. 合并多个NFA（用于处理多条规则）
-    NFA mergeNFAs(const std::vector<NFA> &nfas);
+    unsigned int threads;
 
-    // 5. 计算epsilon闭包
+    // ========== 核心算法实现 ==========
+
+    // 1. Thompson算法：正则语法树 -> NFA (字符类在起始状态上按区间各占一条转移)
+    // 状态编号从 firstStateID 起连续分配，共 thompsonStateCount(tree) 个；各规则据此预先划分互不相交的编号区间
+    static NFA regexToNFA(const RegexNode &tree, const std::string &tokenName, int firstStateID);
+    static int thompsonStateCount(const RegexNode &tree);
+
+    // 2. 合并多个NFA（用于处理多条规则）：prefixes[i] 为第 i 个 NFA 之前的字面串前缀
+    // 各规则的前缀合并为一棵字典树 (确定的字符转移)，共享前缀的规则 (= 与 ==、& 与 &&) 到分叉处才进入各自的 epsilon 分支
+    NFA mergeNFAs(const std::vector<NFA> &nfas, const std::vector<std::string> &prefixes);
+
+    // 2'. 消除 epsilon 转移：每个状态取其 epsilon 闭包内的全部字符转移与优先级最高的终态
+    // 只保留起始状态和字符转移的目标，其余状态只经 epsilon 到达，转移已并入前驱；子集构造在结果上不再需要展开闭包
+    NFA removeEpsilons(const NFA &nfa);
+
+    // 3. 计算epsilon闭包
     std::set<int> epsilonClosure(const NFA &nfa, const std::set<int> &states);
 
-    // 6. 计算状态集合在某个字符下的转换
-    std::set<int> move(const NFA &nfa, const std::set<int> &states, char c);
+    // 4. 计算状态集合在某个字符下的转换
+    std::set<int> move(const NFA &nfa, const std::set<int> &states, unsigned char c);
+
+    // 5. 子集构造法：NFA -> DFA；状态数超过 dfaStateBudget 时中止并返回 false
+    // 每个状态上的转移区间先切成基本区间，每段只做一次 move
+    // 按 BFS 层处理：一层内各状态的 move 与闭包并行计算，新状态再按层内顺序串行编号，与逐个出队的编号一致
+    bool nfaToDFA(const NFA &nfa);
+
+    // 惰性 DFA 模式：把合并后的 NFA 重新编号为紧凑形式 (activeRules 决定规则优先级)
+    void buildCompactNFA(const NFA &nfa, const std::vector<TokenDefinition> &activeRules);
+
+    // 关键字识别：找出被后面的标识符规则覆盖的字面串规则，记入 keywords，返回每条规则是否被移出
+    // trees 为各规则的语法树，accepts(j, text): 第 j 条规则是否匹配 text
+    std::vector<bool> extractKeywords(const std::vector<RegexPtr> &trees, const std::function<bool(size_t, const std::string &)> &accepts);
+    // 语法树是否只匹配一个固定的串 (化简后为单字符的连接)，是则写入 text
+    static bool literalText(const RegexPtr &tree, std::string &text);
+
+    // 5'. followpos 直接构造：语法树 -> DFA；状态数超过 dfaStateBudget 时中止并返回 false
+    bool followposToDFA(const std::vector<RegexPtr> &trees, const std::vector<TokenDefinition> &activeRules);
 
-    // 7. 子集构造法：NFA -> DFA
-    void nfaToDFA(const NFA &nfa);
+    // 5''. 导数构造：状态为每条规则的剩余正则 (导数)，按导数类求转移；状态数超过 dfaStateBudget 时中止并返回 false
+    bool derivativeToDFA(const std::vector<RegexPtr> &trees, const std::vector<TokenDefinition> &activeRules);
 
-    // 8. DFA最小化（Hopcroft算法）
+    // 6. DFA最小化（Hopcroft算法）
     void minimizeDFA();
 
-    // 9. 将内部DFA表示转换为DFATable格式
+    // 7. 将内部DFA表示转换为DFATable格式
     void convertToDFATable(const std::map<int, DFASubset> &dfaStates);
 };
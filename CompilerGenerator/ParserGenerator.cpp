@@ -1,10 +1,15 @@
 #pragma once
 
 #include "ParserGenerator.h"
+#include "GeneratorStats.h"
 #include <iostream>
 
 // 构造函数
-ParserGenerator::ParserGenerator() {
+ParserGenerator::ParserGenerator() : stats(nullptr), closureCalls(0) {
+}
+
+void ParserGenerator::setStats(GeneratorStats* stats) {
+	this->stats = stats;
 }
 
 void ParserGenerator::setStartSymbol(const std::string& startSymbol) {
@@ -39,20 +44,41 @@ void ParserGenerator::build() {
 
 	//先区分终结符与非终结符
 	std::unordered_set<std::string> nonterminals, terminals;
-	sortSymbols(nonterminals, terminals, productions);
+	std::unordered_map<std::string, std::unordered_set<std::string>> first;
+	{
+		StatsPhase phase(stats, "parser.first");
+		sortSymbols(nonterminals, terminals, productions);
 
-	//先计算first集合
-	std::unordered_map<std::string, std::unordered_set<std::string>>first = 
-		computeFirstSets(nonterminals, terminals,productions);
+		//先计算first集合
+		first = computeFirstSets(nonterminals, terminals, productions);
+	}
 
 	//增广
 	this->augmentedProductions = buildAugmentedProductions(startSymbol,productions);
 
 	//构建LR(1)项目集组
-	auto itemSets = buildLR1ItemSets(this->augmentedProductions, first);
+	closureCalls = 0;
+	std::vector<LR1ItemSet> itemSets;
+	{
+		StatsPhase phase(stats, "parser.items");
+		itemSets = buildLR1ItemSets(this->augmentedProductions, first);
+	}
 
 	//构建LR(1)预测分析表
-	buildLR1ParsingTable(nonterminals, terminals,itemSets, this->augmentedProductions, actionTable, gotoTable);
+	{
+		StatsPhase phase(stats, "parser.table");
+		buildLR1ParsingTable(nonterminals, terminals, itemSets, this->augmentedProductions, actionTable, gotoTable);
+	}
+
+	if (stats != nullptr) {
+		stats->setCounter("grammarRules", (long long)productions.size());
+		stats->setCounter("terminals", (long long)terminals.size());
+		stats->setCounter("nonterminals", (long long)nonterminals.size());
+		stats->setCounter("lr1ItemSets", (long long)itemSets.size());
+		stats->setCounter("closureCalls", closureCalls);
+		stats->setCounter("actionEntries", (long long)actionTable.size());
+		stats->setCounter("gotoEntries", (long long)gotoTable.size());
+	}
 }
 
 const ActionTable& ParserGenerator::getActionTable() const {
@@ -194,6 +220,7 @@ std::set<LR1Item> ParserGenerator::closure(
 	const std::vector<ProductionRule>& productions,
 	const std::unordered_map<std::string, std::unordered_set<std::string>>& first) {
 
+	closureCalls++;
 	std::set<LR1Item> result = items;
 	bool changed = true;
 
@@ -35,10 +35,15 @@ struct LR1ItemSet {
     }
 };
 
+class GeneratorStats;
+
 class ParserGenerator {
 public:
     ParserGenerator();
 
+    // 可选：记录构建各阶段的耗时与规模 (--stats)
+    void setStats(GeneratorStats* stats);
+
     // 1. 设置起始符号
     void setStartSymbol(const std::string& startSymbol);
 
@@ -63,6 +68,9 @@ private:
     ActionTable actionTable;
     GotoTable gotoTable;
 
+    GeneratorStats* stats;      // 可为空
+    long long closureCalls;     // closure() 调用次数
+
     //区分终结符与非终结符
     void sortSymbols(
         std::unordered_set<std::string>& nonterminals, 
@@ -0,0 +1,507 @@
+#include "RegexAST.h"
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+// ==========================================
+// 1. 递归下降解析
+// ==========================================
+
+namespace {
+
+RegexPtr makeNode(RegexNode::Kind kind, std::vector<RegexPtr> children) {
+    std::shared_ptr<RegexNode> node = std::make_shared<RegexNode>();
+    node->kind = kind;
+    node->children = std::move(children);
+    return node;
+}
+
+RegexPtr makeCharSet(const CharSet& chars) {
+    std::shared_ptr<RegexNode> node = std::make_shared<RegexNode>();
+    node->kind = RegexNode::CHARSET;
+    node->chars = chars;
+    return node;
+}
+
+RegexPtr makeChar(char c) {
+    CharSet chars;
+    chars.set((unsigned char)c);
+    return makeCharSet(chars);
+}
+
+// r{min,max} 展开为 min 个 r 之后接 (r (r ...)?)?；max < 0 表示不限，接 r*
+// 子树只读，各副本共享同一个 atom
+RegexPtr makeRepeat(const RegexPtr& atom, int min, int max) {
+    std::vector<RegexPtr> items(min, atom);
+    if (max < 0) {
+        items.push_back(makeNode(RegexNode::STAR, { atom }));
+    }
+    else {
+        RegexPtr tail;
+        for (int i = min; i < max; ++i) {
+            tail = makeNode(RegexNode::OPTIONAL, { tail ? makeNode(RegexNode::CONCAT, { atom, tail }) : atom });
+        }
+        if (tail) items.push_back(tail);
+    }
+    if (items.empty()) return makeNode(RegexNode::EMPTY, {});
+    return items.size() == 1 ? items[0] : makeNode(RegexNode::CONCAT, std::move(items));
+}
+
+void addRange(CharSet& chars, unsigned char from, unsigned char to) {
+    for (unsigned int c = from; c <= to; ++c) chars.set(c);
+}
+
+char escapedChar(char c) {
+    if (c == 't') return '\t';
+    if (c == 'n') return '\n';
+    if (c == 'r') return '\r';
+    return c;
+}
+
+class RegexParser {
+public:
+    explicit RegexParser(const std::string& regex) : m_regex(regex), m_pos(0) {}
+
+    RegexPtr parse() {
+        RegexPtr result = parseAlternation();
+        // 多余的 ')' 忽略
+        while (m_pos < m_regex.size()) {
+            ++m_pos;
+            RegexPtr rest = parseAlternation();
+            if (rest->kind != RegexNode::EMPTY) result = makeNode(RegexNode::CONCAT, { result, rest });
+        }
+        return result;
+    }
+
+private:
+    const std::string& m_regex;
+    size_t m_pos;
+
+    bool atEnd() const { return m_pos >= m_regex.size(); }
+
+    RegexPtr parseAlternation() {
+        std::vector<RegexPtr> branches;
+        branches.push_back(parseConcat());
+        while (!atEnd() && m_regex[m_pos] == '|') {
+            ++m_pos;
+            branches.push_back(parseConcat());
+        }
+        return branches.size() == 1 ? branches[0] : makeNode(RegexNode::ALTERNATE, std::move(branches));
+    }
+
+    RegexPtr parseConcat() {
+        std::vector<RegexPtr> items;
+        while (!atEnd() && m_regex[m_pos] != '|' && m_regex[m_pos] != ')') {
+            items.push_back(parseRepeat());
+        }
+        if (items.empty()) return makeNode(RegexNode::EMPTY, {});
+        return items.size() == 1 ? items[0] : makeNode(RegexNode::CONCAT, std::move(items));
+    }
+
+    RegexPtr parseRepeat() {
+        RegexPtr atom = parseAtom();
+        while (!atEnd()) {
+            char op = m_regex[m_pos];
+            int min, max;
+            if (op == '{' && parseBounds(min, max)) {
+                atom = makeRepeat(atom, min, max);
+                continue;
+            }
+            RegexNode::Kind kind;
+            if (op == '*') kind = RegexNode::STAR;
+            else if (op == '+') kind = RegexNode::PLUS;
+            else if (op == '?') kind = RegexNode::OPTIONAL;
+            else break;
+            ++m_pos;
+            atom = makeNode(kind, { atom });
+        }
+        return atom;
+    }
+
+    // 次数上限：更大的数多半是写错了，按字面字符处理
+    static const int REPEAT_LIMIT = 1000;
+
+    // {m} {m,} {m,n}，格式正确时移过它并返回 true；max < 0 表示不限
+    bool parseBounds(int& min, int& max) {
+        size_t pos = m_pos + 1;
+        if (!readNumber(pos, min)) return false;
+        max = min;
+        if (pos < m_regex.size() && m_regex[pos] == ',') {
+            ++pos;
+            max = -1;
+            if (pos < m_regex.size() && m_regex[pos] != '}' && !readNumber(pos, max)) return false;
+        }
+        if (pos >= m_regex.size() || m_regex[pos] != '}') return false;
+        if (max >= 0 && max < min) return false;
+        m_pos = pos + 1;
+        return true;
+    }
+
+    bool readNumber(size_t& pos, int& value) const {
+        size_t begin = pos;
+        value = 0;
+        while (pos < m_regex.size() && m_regex[pos] >= '0' && m_regex[pos] <= '9') {
+            value = value * 10 + (m_regex[pos] - '0');
+            if (value > REPEAT_LIMIT) return false;
+            ++pos;
+        }
+        return pos > begin;
+    }
+
+    RegexPtr parseAtom() {
+        char c = m_regex[m_pos++];
+        if (c == '(') {
+            RegexPtr inner = parseAlternation();
+            if (!atEnd() && m_regex[m_pos] == ')') ++m_pos;
+            return inner;
+        }
+        if (c == '[') {
+            return parseClass();
+        }
+        if (c == '.') {
+            CharSet chars;
+            chars.set();
+            chars.reset('\n');
+            return makeCharSet(chars);
+        }
+        if (c == '\\' && !atEnd()) {
+            char next = m_regex[m_pos++];
+            CharSet chars;
+            if (next == 'd') {
+                addRange(chars, '0', '9');
+            }
+            else if (next == 'w') {
+                addRange(chars, 'a', 'z');
+                addRange(chars, 'A', 'Z');
+                addRange(chars, '0', '9');
+                chars.set('_');
+            }
+            else if (next == 's') {
+                chars.set(' ');
+                chars.set('\t');
+                chars.set('\n');
+                chars.set('\r');
+            }
+            else {
+                return makeChar(escapedChar(next));
+            }
+            return makeCharSet(chars);
+        }
+        // '*' '+' '?' 出现在开头时没有操作数，按字面字符处理
+        return makeChar(c);
+    }
+
+    // '[' 之后到第一个 ']' 为止：先看范围，再看转义；开头的 '^' 表示补集 (单独的 [^] 仍是字面字符 '^')
+    RegexPtr parseClass() {
+        size_t end = m_regex.find(']', m_pos);
+        if (end == std::string::npos) end = m_regex.size();
+        std::string body = m_regex.substr(m_pos, end - m_pos);
+        m_pos = std::min(end + 1, m_regex.size());
+
+        bool negated = body.size() > 1 && body[0] == '^';
+        CharSet chars;
+        for (size_t i = negated ? 1 : 0; i < body.size(); ++i) {
+            if (i + 2 < body.size() && body[i + 1] == '-') {
+                addRange(chars, (unsigned char)body[i], (unsigned char)body[i + 2]);
+                i += 2;
+            }
+            else if (body[i] == '\\' && i + 1 < body.size()) {
+                chars.set((unsigned char)escapedChar(body[i + 1]));
+                ++i;
+            }
+            else {
+                chars.set((unsigned char)body[i]);
+            }
+        }
+        if (negated) chars.flip();
+        return makeCharSet(chars);
+    }
+};
+
+// 有序集合的并
+std::vector<int> unite(const std::vector<int>& a, const std::vector<int>& b) {
+    std::vector<int> result;
+    result.reserve(a.size() + b.size());
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+    return result;
+}
+
+} // namespace
+
+RegexPtr parseRegex(const std::string& regex) {
+    return RegexParser(regex).parse();
+}
+
+CharIntervals charIntervals(const CharSet& chars) {
+    CharIntervals result;
+    unsigned int c = 0;
+    while (c < 256) {
+        if (!chars.test(c)) {
+            ++c;
+            continue;
+        }
+        unsigned int low = c;
+        while (c < 256 && chars.test(c)) ++c;
+        result.push_back(std::make_pair((unsigned char)low, (unsigned char)(c - 1)));
+    }
+    return result;
+}
+
+// ==========================================
+// 2. 化简
+// ==========================================
+
+namespace {
+
+bool singleChar(const RegexNode& node, char& c) {
+    if (node.kind != RegexNode::CHARSET || node.chars.count() != 1) return false;
+    for (unsigned int i = 0; i < 256; ++i) {
+        if (node.chars.test(i)) c = (char)i;
+    }
+    return true;
+}
+
+bool sameRegex(const RegexNode& a, const RegexNode& b) {
+    if (&a == &b) return true;
+    if (a.kind != b.kind || a.chars != b.chars || a.children.size() != b.children.size()) return false;
+    for (size_t i = 0; i < a.children.size(); ++i) {
+        if (!sameRegex(*a.children[i], *b.children[i])) return false;
+    }
+    return true;
+}
+
+bool isClosure(RegexNode::Kind kind) {
+    return kind == RegexNode::STAR || kind == RegexNode::PLUS || kind == RegexNode::OPTIONAL;
+}
+
+// 闭包 outer 作用在 inner 上：两层同种闭包等于一层，不同种的两层都等于 r*
+RegexPtr makeClosure(RegexNode::Kind outer, const RegexPtr& inner) {
+    if (inner->kind == RegexNode::EMPTY) return inner;
+    if (!isClosure(inner->kind)) return makeNode(outer, { inner });
+    if (inner->kind == outer || inner->kind == RegexNode::STAR) return inner;
+    return makeNode(RegexNode::STAR, { inner->children[0] });
+}
+
+class Simplifier {
+public:
+    RegexPtr simplify(const RegexPtr& node) {
+        auto it = m_done.find(node.get());
+        if (it != m_done.end()) return it->second;
+        RegexPtr result = visit(node);
+        m_done[node.get()] = result;
+        return result;
+    }
+
+private:
+    std::map<const RegexNode*, RegexPtr> m_done;
+
+    RegexPtr visit(const RegexPtr& node) {
+        switch (node->kind) {
+        case RegexNode::EMPTY:
+        case RegexNode::CHARSET:
+            return node;
+
+        case RegexNode::CONCAT: {
+            std::vector<RegexPtr> items;
+            for (const auto& child : node->children) {
+                RegexPtr item = simplify(child);
+                if (item->kind == RegexNode::EMPTY) continue;
+                if (item->kind == RegexNode::CONCAT) items.insert(items.end(), item->children.begin(), item->children.end());
+                else items.push_back(item);
+            }
+            if (items.empty()) return makeNode(RegexNode::EMPTY, {});
+            return items.size() == 1 ? items[0] : makeNode(RegexNode::CONCAT, std::move(items));
+        }
+
+        case RegexNode::ALTERNATE: {
+            std::vector<RegexPtr> branches;
+            CharSet chars;
+            int charsAt = -1;  // 合并后的字符集放在第一个字符集分支的位置
+            int charsCount = 0;
+            bool hasEmpty = false;
+            for (const auto& child : node->children) {
+                RegexPtr item = simplify(child);
+                std::vector<RegexPtr> flat;
+                if (item->kind == RegexNode::ALTERNATE) flat = item->children;
+                else flat.push_back(item);
+                for (const auto& branch : flat) {
+                    if (branch->kind == RegexNode::EMPTY) {
+                        hasEmpty = true;
+                        continue;
+                    }
+                    if (branch->kind == RegexNode::CHARSET) {
+                        if (charsAt < 0) {
+                            charsAt = (int)branches.size();
+                            branches.push_back(branch);
+                        }
+                        chars |= branch->chars;
+                        ++charsCount;
+                        continue;
+                    }
+                    bool duplicate = false;
+                    for (size_t i = 0; i < branches.size() && !duplicate; ++i) {
+                        duplicate = sameRegex(*branches[i], *branch);
+                    }
+                    if (!duplicate) branches.push_back(branch);
+                }
+            }
+            if (charsCount > 1) branches[charsAt] = makeCharSet(chars);
+
+            RegexPtr result;
+            if (branches.empty()) result = makeNode(RegexNode::EMPTY, {});
+            else if (branches.size() == 1) result = branches[0];
+            else result = makeNode(RegexNode::ALTERNATE, std::move(branches));
+            return hasEmpty ? makeClosure(RegexNode::OPTIONAL, result) : result;
+        }
+
+        case RegexNode::STAR:
+        case RegexNode::PLUS:
+        case RegexNode::OPTIONAL:
+            return makeClosure(node->kind, simplify(node->children[0]));
+        }
+        return node;
+    }
+};
+
+} // namespace
+
+RegexPtr simplifyRegex(const RegexPtr& tree) {
+    return Simplifier().simplify(tree);
+}
+
+RegexPtr splitLiteralPrefix(const RegexPtr& tree, std::string& prefix) {
+    prefix.clear();
+    char c;
+    if (singleChar(*tree, c)) {
+        prefix += c;
+        return makeNode(RegexNode::EMPTY, {});
+    }
+    if (tree->kind != RegexNode::CONCAT) return tree;
+
+    size_t i = 0;
+    while (i < tree->children.size() && singleChar(*tree->children[i], c)) {
+        prefix += c;
+        ++i;
+    }
+    if (i == 0) return tree;
+    std::vector<RegexPtr> rest(tree->children.begin() + i, tree->children.end());
+    if (rest.empty()) return makeNode(RegexNode::EMPTY, {});
+    return rest.size() == 1 ? rest[0] : makeNode(RegexNode::CONCAT, std::move(rest));
+}
+
+// ==========================================
+// 3. 位置自动机
+// ==========================================
+
+int PositionAutomaton::newPosition(int accept) {
+    m_accept.push_back(accept);
+    m_chars.push_back(CharIntervals());
+    m_follow.push_back(std::vector<int>());
+    return (int)m_accept.size() - 1;
+}
+
+PositionAutomaton::Info PositionAutomaton::visit(const RegexNode& node) {
+    Info info;
+    switch (node.kind) {
+    case RegexNode::EMPTY:
+        info.nullable = true;
+        break;
+
+    case RegexNode::CHARSET: {
+        int position = newPosition(-1);
+        m_chars[position] = charIntervals(node.chars);
+        info.nullable = false;
+        info.first.push_back(position);
+        info.last.push_back(position);
+        break;
+    }
+
+    case RegexNode::CONCAT: {
+        info = visit(*node.children[0]);
+        for (size_t i = 1; i < node.children.size(); ++i) {
+            Info next = visit(*node.children[i]);
+            // 左边的 lastpos 之后可以接右边的 firstpos
+            for (int p : info.last) {
+                m_follow[p].insert(m_follow[p].end(), next.first.begin(), next.first.end());
+            }
+            if (info.nullable) info.first = unite(info.first, next.first);
+            info.last = next.nullable ? unite(info.last, next.last) : next.last;
+            info.nullable = info.nullable && next.nullable;
+        }
+        break;
+    }
+
+    case RegexNode::ALTERNATE: {
+        info.nullable = false;
+        for (const auto& child : node.children) {
+            Info branch = visit(*child);
+            info.nullable = info.nullable || branch.nullable;
+            info.first = unite(info.first, branch.first);
+            info.last = unite(info.last, branch.last);
+        }
+        break;
+    }
+
+    case RegexNode::STAR:
+    case RegexNode::PLUS:
+    case RegexNode::OPTIONAL: {
+        info = visit(*node.children[0]);
+        if (node.kind != RegexNode::OPTIONAL) {
+            // 闭包：lastpos 之后可以回到 firstpos
+            for (int p : info.last) {
+                m_follow[p].insert(m_follow[p].end(), info.first.begin(), info.first.end());
+            }
+        }
+        if (node.kind != RegexNode::PLUS) info.nullable = true;
+        break;
+    }
+    }
+    return info;
+}
+
+void PositionAutomaton::addRule(const RegexPtr& tree, int priority) {
+    Info info = visit(*tree);
+    int endMarker = newPosition(priority);
+    for (int p : info.last) m_follow[p].push_back(endMarker);
+    std::vector<int> first = info.first;
+    if (info.nullable) first.push_back(endMarker);
+    m_start = unite(m_start, first);
+}
+
+void PositionAutomaton::finish() {
+    for (auto& follow : m_follow) {
+        std::sort(follow.begin(), follow.end());
+        follow.erase(std::unique(follow.begin(), follow.end()), follow.end());
+    }
+}
+
+bool regexMatches(const RegexPtr& tree, const std::string& text) {
+    PositionAutomaton automaton;
+    automaton.addRule(tree, 0);
+    automaton.finish();
+    return regexMatches(automaton, text);
+}
+
+bool regexMatches(const PositionAutomaton& automaton, const std::string& text) {
+    std::vector<int> current = automaton.start();
+    for (char c : text) {
+        unsigned char byte = (unsigned char)c;
+        std::vector<int> next;
+        for (int p : current) {
+            for (const auto& interval : automaton.chars(p)) {
+                if (interval.first <= byte && byte <= interval.second) {
+                    next.insert(next.end(), automaton.follow(p).begin(), automaton.follow(p).end());
+                    break;
+                }
+            }
+        }
+        std::sort(next.begin(), next.end());
+        next.erase(std::unique(next.begin(), next.end()), next.end());
+        if (next.empty()) return false;
+        current.swap(next);
+    }
+    for (int p : current) {
+        if (automaton.accept(p) >= 0) return true;
+    }
+    return false;
+}
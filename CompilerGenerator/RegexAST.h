@@ -0,0 +1,94 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <bitset>
+
+// 正则表达式语法树
+// parseRegex 直接从规则文件中的正则递归下降解析得到，三种 DFA 构造方法共用：
+// - 运算符 | * + ? 与括号；\d \w \s 展开为字符类，\t \n \r 为控制字符，其余 \x 为字面字符 x
+// - [...] 为字符类，支持 a-z 范围与 \t \n \r 转义 (类内的 \d 等按字面字符处理)；[^...] 为补集 (0 ~ 255 中不在类里的字节)
+// - '.' 为换行以外的任意字节
+// - r{m} / r{m,} / r{m,n} 为重复次数，展开为 m 个 r 加上嵌套的可选项 (或 r*)；格式不对的 '{' 按字面字符处理
+// - 其余字符均为字面字符
+
+using CharSet = std::bitset<256>;
+
+// 字符集的区间表示：按 low 升序、互不相邻的 [low, high]
+using CharIntervals = std::vector<std::pair<unsigned char, unsigned char>>;
+CharIntervals charIntervals(const CharSet& chars);
+
+struct RegexNode;
+using RegexPtr = std::shared_ptr<const RegexNode>;
+
+struct RegexNode {
+    enum Kind {
+        EMPTY,     // 空串
+        CHARSET,   // 字符集中的任一字符
+        CONCAT,    // children 依次连接
+        ALTERNATE, // children 任选其一
+        STAR,      // children[0]*
+        PLUS,      // children[0]+
+        OPTIONAL,  // children[0]?
+    };
+
+    Kind kind;
+    CharSet chars;                  // CHARSET
+    std::vector<RegexPtr> children; // CONCAT / ALTERNATE 至少两个，闭包类只有一个
+};
+
+RegexPtr parseRegex(const std::string& regex);
+
+// 化简 (语言不变)，在构造自动机之前做一次：
+// - 展平嵌套的连接与并，去掉连接中的空串
+// - 并中所有字符集分支合并为一个 (a|[b-c]|d => [a-d])，去掉重复分支；有空串分支时改为 (...)?
+// - 叠加的闭包合为一个：(r*)* (r+)* (r?)* (r*)? (r+)? => r*，(r+)+ => r+，(r?)? => r?
+// 共享的子树 (r{m,n} 展开的副本) 只化简一次，结果仍然共享
+RegexPtr simplifyRegex(const RegexPtr& tree);
+
+// 拆出开头的字面串：tree 匹配的语言 = prefix 后接返回的语法树 (开头没有单字符时 prefix 为空)
+RegexPtr splitLiteralPrefix(const RegexPtr& tree, std::string& prefix);
+
+// 位置自动机 (followpos)
+// 所有规则的语法树并联为 (r0 #0) | (r1 #1) | ...，每个字符集叶子与每个结束标记 #i 各占一个位置；
+// 计算 nullable / firstpos / lastpos 后得到 followpos，位置集合即 DFA 状态，不需要 epsilon 转移
+class PositionAutomaton {
+public:
+    // 加入一条规则，priority 越小优先级越高 (结束标记位置上的 accept 值)
+    void addRule(const RegexPtr& tree, int priority);
+
+    // 起始状态：所有规则 firstpos 的并集 (有序)
+    const std::vector<int>& start() const { return m_start; }
+
+    size_t positionCount() const { return m_accept.size(); }
+    // 字符位置为 -1，结束标记为规则的 priority
+    int accept(int position) const { return m_accept[position]; }
+    // 字符位置上可以出现的字符 (区间，升序)
+    const CharIntervals& chars(int position) const { return m_chars[position]; }
+    // followpos (有序)
+    const std::vector<int>& follow(int position) const { return m_follow[position]; }
+
+    // 所有规则加入后调用一次：把各位置的 followpos 整理为有序无重复
+    void finish();
+
+private:
+    struct Info {
+        bool nullable;
+        std::vector<int> first;
+        std::vector<int> last;
+    };
+
+    Info visit(const RegexNode& node);
+    int newPosition(int accept);
+
+    std::vector<int> m_start;
+    std::vector<int> m_accept;
+    std::vector<CharIntervals> m_chars;
+    std::vector<std::vector<int>> m_follow;
+};
+
+// 位置自动机是否接受整个 text (模拟位置集合)
+bool regexMatches(const PositionAutomaton& automaton, const std::string& text);
+// 同上，临时为单个语法树构造位置自动机
+bool regexMatches(const RegexPtr& tree, const std::string& text);
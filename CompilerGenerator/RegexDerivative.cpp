@@ -0,0 +1,230 @@
+#include "RegexDerivative.h"
+#include <algorithm>
+
+// 字符集的紧凑键：32 字节，每字节 8 个字符
+static std::string charKey(const CharSet& chars) {
+    std::string key(32, '\0');
+    for (unsigned int c = 0; c < 256; ++c) {
+        if (chars.test(c)) key[c / 8] = (char)(key[c / 8] | (1 << (c % 8)));
+    }
+    return key;
+}
+
+bool DerivativeTerms::TermKey::operator<(const TermKey& other) const {
+    if (kind != other.kind) return kind < other.kind;
+    if (chars != other.chars) return chars < other.chars;
+    return children < other.children;
+}
+
+DerivativeTerms::DerivativeTerms() {
+    intern(NOTHING, CharSet(), std::vector<int>(), false);
+    intern(EPSILON, CharSet(), std::vector<int>(), true);
+}
+
+int DerivativeTerms::intern(Kind kind, const CharSet& chars, const std::vector<int>& children, bool nullable) {
+    TermKey key;
+    key.kind = kind;
+    if (kind == CHARS) key.chars = charKey(chars);
+    key.children = children;
+    auto it = m_index.find(key);
+    if (it != m_index.end()) return it->second;
+
+    Term term;
+    term.kind = kind;
+    term.chars = chars;
+    term.children = children;
+    term.nullable = nullable;
+    int id = (int)m_terms.size();
+    m_terms.push_back(term);
+    m_index[key] = id;
+    return id;
+}
+
+// ==========================================
+// 1. 智能构造函数
+// ==========================================
+
+int DerivativeTerms::makeChars(const CharSet& chars) {
+    if (chars.none()) return NOTHING_TERM;
+    return intern(CHARS, chars, std::vector<int>(), false);
+}
+
+int DerivativeTerms::makeConcat(int left, int right) {
+    if (left == NOTHING_TERM || right == NOTHING_TERM) return NOTHING_TERM;
+    if (left == EPSILON_TERM) return right;
+    if (right == EPSILON_TERM) return left;
+    // (a . b) . c => a . (b . c)
+    if (m_terms[left].kind == CONCAT) {
+        int first = m_terms[left].children[0];
+        int second = m_terms[left].children[1];
+        return makeConcat(first, makeConcat(second, right));
+    }
+    bool nullable = m_terms[left].nullable && m_terms[right].nullable;
+    return intern(CONCAT, CharSet(), std::vector<int>{ left, right }, nullable);
+}
+
+int DerivativeTerms::makeAlternate(std::vector<int> terms) {
+    // 展平嵌套的并，字符集合并为一个
+    std::vector<int> flat;
+    CharSet chars;
+    bool haveChars = false;
+    for (size_t i = 0; i < terms.size(); ++i) {
+        const Term& term = m_terms[terms[i]];
+        if (term.kind == NOTHING) continue;
+        if (term.kind == ALTERNATE) {
+            for (int child : term.children) {
+                if (m_terms[child].kind == CHARS) {
+                    chars |= m_terms[child].chars;
+                    haveChars = true;
+                }
+                else {
+                    flat.push_back(child);
+                }
+            }
+        }
+        else if (term.kind == CHARS) {
+            chars |= term.chars;
+            haveChars = true;
+        }
+        else {
+            flat.push_back(terms[i]);
+        }
+    }
+    if (haveChars) flat.push_back(makeChars(chars));
+    std::sort(flat.begin(), flat.end());
+    flat.erase(std::unique(flat.begin(), flat.end()), flat.end());
+
+    if (flat.empty()) return NOTHING_TERM;
+    if (flat.size() == 1) return flat[0];
+    bool nullable = false;
+    for (int t : flat) nullable = nullable || m_terms[t].nullable;
+    return intern(ALTERNATE, CharSet(), flat, nullable);
+}
+
+int DerivativeTerms::makeStar(int term) {
+    if (term == NOTHING_TERM || term == EPSILON_TERM) return EPSILON_TERM;
+    if (m_terms[term].kind == STAR) return term;
+    return intern(STAR, CharSet(), std::vector<int>{ term }, true);
+}
+
+int DerivativeTerms::fromTree(const RegexNode& node) {
+    switch (node.kind) {
+    case RegexNode::EMPTY:
+        return EPSILON_TERM;
+    case RegexNode::CHARSET:
+        return makeChars(node.chars);
+    case RegexNode::CONCAT: {
+        int result = EPSILON_TERM;
+        for (size_t i = node.children.size(); i-- > 0;) {
+            result = makeConcat(fromTree(*node.children[i]), result);
+        }
+        return result;
+    }
+    case RegexNode::ALTERNATE: {
+        std::vector<int> branches;
+        for (const auto& child : node.children) branches.push_back(fromTree(*child));
+        return makeAlternate(branches);
+    }
+    case RegexNode::STAR:
+        return makeStar(fromTree(*node.children[0]));
+    case RegexNode::PLUS: {
+        // r+ = r . r*
+        int inner = fromTree(*node.children[0]);
+        return makeConcat(inner, makeStar(inner));
+    }
+    case RegexNode::OPTIONAL:
+        return makeAlternate(std::vector<int>{ fromTree(*node.children[0]), EPSILON_TERM });
+    }
+    return NOTHING_TERM;
+}
+
+// ==========================================
+// 2. 导数与导数类
+// ==========================================
+
+int DerivativeTerms::derive(int term, unsigned char c) {
+    long long key = (long long)term * 256 + c;
+    auto cached = m_derivatives.find(key);
+    if (cached != m_derivatives.end()) return cached->second;
+
+    int result = NOTHING_TERM;
+    // 注意：intern 可能扩容 m_terms，这里复制需要的字段而不是持有引用
+    Kind kind = m_terms[term].kind;
+    std::vector<int> children = m_terms[term].children;
+    switch (kind) {
+    case NOTHING:
+    case EPSILON:
+        result = NOTHING_TERM;
+        break;
+    case CHARS:
+        result = m_terms[term].chars.test(c) ? EPSILON_TERM : NOTHING_TERM;
+        break;
+    case CONCAT: {
+        // d(r . s) = d(r) . s | (nullable(r) ? d(s) : ∅)
+        int left = makeConcat(derive(children[0], c), children[1]);
+        if (m_terms[children[0]].nullable) {
+            result = makeAlternate(std::vector<int>{ left, derive(children[1], c) });
+        }
+        else {
+            result = left;
+        }
+        break;
+    }
+    case ALTERNATE: {
+        std::vector<int> branches;
+        for (int child : children) branches.push_back(derive(child, c));
+        result = makeAlternate(branches);
+        break;
+    }
+    case STAR:
+        // d(r*) = d(r) . r*
+        result = makeConcat(derive(children[0], c), term);
+        break;
+    }
+
+    m_derivatives[key] = result;
+    return result;
+}
+
+// 两个划分的交：两两求交，保留非空的类
+std::vector<CharSet> DerivativeTerms::intersectClasses(const std::vector<CharSet>& a, const std::vector<CharSet>& b) {
+    std::vector<CharSet> result;
+    for (const auto& x : a) {
+        for (const auto& y : b) {
+            CharSet both = x & y;
+            if (both.any()) result.push_back(both);
+        }
+    }
+    return result;
+}
+
+const std::vector<CharSet>& DerivativeTerms::classes(int term) {
+    auto cached = m_classes.find(term);
+    if (cached != m_classes.end()) return cached->second;
+
+    std::vector<CharSet> result;
+    Kind kind = m_terms[term].kind;
+    std::vector<int> children = m_terms[term].children;
+    switch (kind) {
+    case NOTHING:
+    case EPSILON:
+        result.push_back(CharSet().set());
+        break;
+    case CHARS:
+        result.push_back(m_terms[term].chars);
+        if (!m_terms[term].chars.all()) result.push_back(~m_terms[term].chars);
+        break;
+    case CONCAT:
+        result = classes(children[0]);
+        if (m_terms[children[0]].nullable) result = intersectClasses(result, classes(children[1]));
+        break;
+    case ALTERNATE:
+        result = classes(children[0]);
+        for (size_t i = 1; i < children.size(); ++i) result = intersectClasses(result, classes(children[i]));
+        break;
+    case STAR:
+        result = classes(children[0]);
+        break;
+    }
+    return m_classes[term] = result;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "RegexAST.h"
+#include <map>
+#include <unordered_map>
+
+// Brzozowski 导数
+// 正则项全部哈希构造 (hash-consing)，每个项有唯一编号；构造时由智能构造函数化简为规范形式：
+// - 并：展平嵌套、去掉 ∅、字符集合并为一个、按编号排序去重
+// - 连接：∅ 吸收、ε 消去、右结合
+// - 闭包：(r*)* = r*，ε* = ∅* = ε
+// 相似的项因此得到同一个编号，导数构造出的 DFA 状态数有限且接近最小
+class DerivativeTerms {
+public:
+    DerivativeTerms();
+
+    // 语法树转为项
+    int fromTree(const RegexNode& node);
+
+    int nothing() const { return NOTHING_TERM; } // ∅
+    bool nullable(int term) const { return m_terms[term].nullable; }
+
+    // 对字符 c 求导 (有缓存)
+    int derive(int term, unsigned char c);
+
+    // 导数类：把字符划分为若干类，同一类中的字符对 term 求导结果相同 (有缓存)
+    const std::vector<CharSet>& classes(int term);
+
+    size_t termCount() const { return m_terms.size(); }
+
+private:
+    enum Kind { NOTHING, EPSILON, CHARS, CONCAT, ALTERNATE, STAR };
+
+    static const int NOTHING_TERM = 0;
+    static const int EPSILON_TERM = 1;
+
+    struct Term {
+        Kind kind;
+        CharSet chars;             // CHARS
+        std::vector<int> children; // CONCAT 两个，ALTERNATE 至少两个 (有序)，STAR 一个
+        bool nullable;
+    };
+
+    // 哈希构造的键：种类、字符集与子项
+    struct TermKey {
+        int kind;
+        std::string chars;
+        std::vector<int> children;
+        bool operator<(const TermKey& other) const;
+    };
+
+    int intern(Kind kind, const CharSet& chars, const std::vector<int>& children, bool nullable);
+
+    // 智能构造函数
+    int makeChars(const CharSet& chars);
+    int makeConcat(int left, int right);
+    int makeAlternate(std::vector<int> terms);
+    int makeStar(int term);
+
+    static std::vector<CharSet> intersectClasses(const std::vector<CharSet>& a, const std::vector<CharSet>& b);
+
+    std::vector<Term> m_terms;
+    std::map<TermKey, int> m_index;
+    std::unordered_map<long long, int> m_derivatives;  // term * 256 + c -> 导数
+    std::map<int, std::vector<CharSet>> m_classes;
+};
@@ -0,0 +1,490 @@
+#include "SentenceGenerator.h"
+#include "TemplateRenderer.h"
+#include "ParserGenerator.h"
+#include <iostream>
+#include <map>
+#include <queue>
+#include <algorithm>
+
+// 词素超过这个长度后只沿着离终态更近的转移走
+static const size_t LEXEME_SOFT_LIMIT = 8;
+
+// 同一段连续被 LR 表拒绝这么多次就放弃
+static const int MAX_RETRIES = 1000;
+
+SentenceGenerator::SentenceGenerator(const std::vector<ProductionRule>& rules, const DFATable& dfa,
+                                     const ActionTable& actionTbl, const GotoTable& gotoTbl)
+    : m_rules(rules), m_dfa(dfa), m_actionTable(actionTbl), m_gotoTable(gotoTbl), m_stateCount(0), m_fillAssigned(false) {}
+
+// ==========================================
+// 1. 建表
+// ==========================================
+
+bool SentenceGenerator::prepare() {
+    m_productions.clear();
+    m_nonterminals.clear();
+    m_terminals.clear();
+    if (m_rules.empty() || m_dfa.empty()) {
+        std::cerr << "[SentenceGen] Grammar or DFA is empty." << std::endl;
+        return false;
+    }
+
+    // 非终结符：所有出现在左部的符号；其余都是终结符
+    std::map<std::string, int> nonterminalIds;
+    for (const auto& rule : m_rules) {
+        if (nonterminalIds.count(rule.lhs)) continue;
+        nonterminalIds[rule.lhs] = (int)m_nonterminals.size();
+        Nonterminal nt;
+        nt.name = rule.lhs;
+        nt.height = INF_HEIGHT;
+        m_nonterminals.push_back(nt);
+    }
+
+    std::map<std::string, int> terminalIds;
+    for (const auto& rule : m_rules) {
+        Production production;
+        production.lhs = nonterminalIds[rule.lhs];
+        production.height = INF_HEIGHT;
+        for (const auto& symbol : rule.rhs) {
+            auto nt = nonterminalIds.find(symbol);
+            if (nt != nonterminalIds.end()) {
+                production.rhs.push_back(nt->second);
+                continue;
+            }
+            auto t = terminalIds.find(symbol);
+            if (t == terminalIds.end()) {
+                t = terminalIds.insert(std::make_pair(symbol, (int)m_terminals.size())).first;
+                Terminal terminal;
+                terminal.name = symbol;
+                m_terminals.push_back(terminal);
+            }
+            production.rhs.push_back(-(t->second + 1));
+        }
+
+        // 直接左递归 / 右递归的产生式化为重复；A -> A 这种无意义的产生式直接丢弃
+        int index = (int)m_productions.size();
+        Nonterminal& nt = m_nonterminals[production.lhs];
+        const std::vector<int>& rhs = production.rhs;
+        if (rhs.size() == 1 && rhs[0] == production.lhs) continue;
+        if (!rhs.empty() && rhs.front() == production.lhs) nt.lefts.push_back(index);
+        else if (!rhs.empty() && rhs.back() == production.lhs) nt.rights.push_back(index);
+        else nt.bases.push_back(index);
+        m_productions.push_back(production);
+    }
+
+    computeHeights();
+    buildParseTables(nonterminalIds, terminalIds);
+    bool ok = true;
+    for (const auto& nt : m_nonterminals) {
+        if (nt.height >= INF_HEIGHT) {
+            std::cerr << "[SentenceGen] Nonterminal " << nt.name << " cannot derive a terminal string." << std::endl;
+            ok = false;
+        }
+    }
+
+    // DFA：按 stateID 建立可打印字符的转移表
+    m_stateIndex.clear();
+    for (size_t i = 0; i < m_dfa.size(); ++i) m_stateIndex[m_dfa[i].stateID] = (int)i;
+    m_moves.assign(m_dfa.size(), std::vector<CharRange>());
+    for (size_t i = 0; i < m_dfa.size(); ++i) {
+        for (const auto& move : m_dfa[i].transitions) {
+            // 区间截到可打印字符 [32, 126]
+            unsigned char low = std::max<unsigned char>(move.low, 32);
+            unsigned char high = std::min<unsigned char>(move.high, 126);
+            if (low > high) continue;
+            auto target = m_stateIndex.find(move.target);
+            if (target != m_stateIndex.end()) m_moves[i].push_back(CharRange{low, high, target->second});
+        }
+    }
+
+    m_keywordTexts.clear();
+    for (const auto& keyword : m_keywords) m_keywordTexts.insert(keyword.text);
+    for (auto& terminal : m_terminals) {
+        if (!buildTerminal(terminal)) {
+            std::cerr << "[SentenceGen] Token " << terminal.name << " cannot be produced by the lexer." << std::endl;
+            ok = false;
+        }
+    }
+
+    if (!pickSeparators()) {
+        std::cout << "[SentenceGen] Warning: no whitespace SKIP token found, tokens are written without separators." << std::endl;
+    }
+    return ok;
+}
+
+void SentenceGenerator::buildParseTables(const std::map<std::string, int>& nonterminalIds,
+                                         const std::map<std::string, int>& terminalIds) {
+    m_stateCount = 0;
+    for (const auto& entry : m_actionTable) m_stateCount = std::max(m_stateCount, entry.first.first + 1);
+    for (const auto& entry : m_gotoTable) m_stateCount = std::max(m_stateCount, std::max(entry.first.first, entry.second) + 1);
+
+    size_t columns = m_terminals.size() + 1;
+    m_action.assign((size_t)m_stateCount * columns, 0);
+    for (const auto& entry : m_actionTable) {
+        int column;
+        if (entry.first.second == END_MARKER) {
+            column = (int)m_terminals.size();
+        }
+        else {
+            auto t = terminalIds.find(entry.first.second);
+            if (t == terminalIds.end()) continue;
+            column = t->second;
+        }
+        int& cell = m_action[(size_t)entry.first.first * columns + column];
+        switch (entry.second.type) {
+        case ACTION_SHIFT: cell = entry.second.target + 1; break;
+        case ACTION_REDUCE: cell = -(entry.second.target + 1); break;
+        case ACTION_ACCEPT: cell = -1; break;
+        default: break;
+        }
+    }
+
+    m_goto.assign((size_t)m_stateCount * m_nonterminals.size(), -1);
+    for (const auto& entry : m_gotoTable) {
+        auto nt = nonterminalIds.find(entry.first.second);
+        if (nt == nonterminalIds.end()) continue;
+        m_goto[(size_t)entry.first.first * m_nonterminals.size() + nt->second] = entry.second;
+    }
+
+    m_ruleLength.clear();
+    m_ruleLhs.clear();
+    for (const auto& rule : m_rules) {
+        m_ruleLength.push_back((int)rule.rhs.size());
+        m_ruleLhs.push_back(nonterminalIds.find(rule.lhs)->second);
+    }
+}
+
+// 让 LR 自动机读入一个终结符 (先做完所有归约再移进)；被拒绝返回 false
+bool SentenceGenerator::feed(std::vector<int>& states, int terminal) const {
+    size_t columns = m_terminals.size() + 1;
+    while (true) {
+        int action = m_action[(size_t)states.back() * columns + terminal];
+        if (action > 0) {
+            states.push_back(action - 1);
+            return true;
+        }
+        if (action == 0) return false;
+
+        int rule = -action - 1;
+        if (rule == 0) return terminal == (int)m_terminals.size();
+        states.resize(states.size() - m_ruleLength[rule]);
+        int next = m_goto[(size_t)states.back() * m_nonterminals.size() + m_ruleLhs[rule]];
+        if (next < 0) return false;
+        states.push_back(next);
+    }
+}
+
+// 最小推导高度：不动点迭代，只用非递归产生式 (递归产生式展开为重复，不增加高度)
+void SentenceGenerator::computeHeights() {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto& production : m_productions) {
+            int height = 0;
+            for (int symbol : production.rhs) {
+                int h = symbol < 0 ? 0 : m_nonterminals[symbol].height;
+                if (h > height) height = h;
+            }
+            height = height >= INF_HEIGHT ? INF_HEIGHT : height + 1;
+            if (height < production.height) {
+                production.height = height;
+                changed = true;
+            }
+        }
+        for (auto& nt : m_nonterminals) {
+            for (int index : nt.bases) {
+                if (m_productions[index].height < nt.height) {
+                    nt.height = m_productions[index].height;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+// 反向 BFS：每个状态到该 Token 终态的最短距离
+bool SentenceGenerator::buildTerminal(Terminal& terminal) {
+    // 关键字：DFA 把字面串识别为覆盖它的规则，生成的词法分析器再改判回来
+    terminal.keyword.clear();
+    for (const auto& keyword : m_keywords) {
+        if (keyword.name != terminal.name) continue;
+        int state = run(0, keyword.text);
+        if (state < 0 || !m_dfa[state].isFinal || m_dfa[state].tokenName != keyword.coverName) return false;
+        terminal.keyword = keyword.text;
+        terminal.keywordState = state;
+        return true;
+    }
+
+    std::vector<std::vector<int>> predecessors(m_dfa.size());
+    for (size_t i = 0; i < m_moves.size(); ++i) {
+        for (const auto& move : m_moves[i]) predecessors[move.target].push_back((int)i);
+    }
+
+    terminal.distance.assign(m_dfa.size(), -1);
+    std::queue<int> queue;
+    for (size_t i = 0; i < m_dfa.size(); ++i) {
+        if (m_dfa[i].isFinal && m_dfa[i].tokenName == terminal.name) {
+            terminal.distance[i] = 0;
+            queue.push((int)i);
+        }
+    }
+    while (!queue.empty()) {
+        int state = queue.front();
+        queue.pop();
+        for (int prev : predecessors[state]) {
+            if (terminal.distance[prev] >= 0) continue;
+            terminal.distance[prev] = terminal.distance[state] + 1;
+            queue.push(prev);
+        }
+    }
+
+    terminal.reachable.assign(m_dfa.size(), std::vector<CharRange>());
+    terminal.closer.assign(m_dfa.size(), std::vector<CharRange>());
+    for (size_t i = 0; i < m_moves.size(); ++i) {
+        for (const auto& move : m_moves[i]) {
+            int d = terminal.distance[move.target];
+            if (d < 0) continue;
+            terminal.reachable[i].push_back(move);
+            if (d < terminal.distance[i]) terminal.closer[i].push_back(move);
+        }
+    }
+    // 起始状态本身是终态意味着空串，不能作为词素
+    return terminal.distance[0] > 0;
+}
+
+// 在 DFA 上从 state 出发读入 text，返回到达的状态下标；中途无路可走返回 -1
+int SentenceGenerator::run(int state, const std::string& text) const {
+    for (char c : text) {
+        int target = findTransition(m_dfa[state].transitions, (unsigned char)c);
+        if (target < 0) return -1;
+        auto next = m_stateIndex.find(target);
+        if (next == m_stateIndex.end()) return -1;
+        state = next->second;
+    }
+    return state;
+}
+
+bool SentenceGenerator::pickSeparators() {
+    auto isSkip = [this](const std::string& text) {
+        int state = run(0, text);
+        return state >= 0 && m_dfa[state].isFinal && m_dfa[state].tokenName == "SKIP";
+    };
+    m_separator = isSkip(" ") ? " " : (isSkip("\n") ? "\n" : "");
+    m_lineSeparator = isSkip("\n") ? "\n" : m_separator;
+    return !m_separator.empty();
+}
+
+// ==========================================
+// 2. 生成
+// ==========================================
+
+bool SentenceGenerator::generateFile(const std::string& path) {
+    OutputSink out(path);
+    if (!out.isOpen()) {
+        std::cerr << "Error: Could not open file " << path << " for writing." << std::endl;
+        return false;
+    }
+    if (!generate(out)) return false;
+    return out.close();
+}
+
+bool SentenceGenerator::generate(OutputSink& out) {
+    if (m_productions.empty()) return false;
+    m_random.seed(m_options.seed);
+    m_fillAssigned = false;
+    m_pendingText.clear();
+    m_pendingTerminals.clear();
+
+    std::vector<Frame> stack;
+    expand(m_productions[0].lhs, 0, stack);
+
+    // 校验点：已写出部分对应的 LR 状态栈，以及当时的工作栈
+    std::vector<int> states(1, 0);
+    std::vector<Frame> savedStack = stack;
+    bool savedFillAssigned = m_fillAssigned;
+    int retries = 0;
+
+    while (true) {
+        // 每当最外层列表准备再重复一次 (或整个推导结束)，校验并写出这一段
+        bool checkpoint = stack.empty() || stack.back().fill;
+        if (checkpoint) {
+            std::vector<int> trial = states;
+            bool accepted = true;
+            for (size_t i = 0; accepted && i < m_pendingTerminals.size(); ++i) {
+                accepted = feed(trial, m_pendingTerminals[i]);
+            }
+            if (accepted && stack.empty()) accepted = feed(trial, (int)m_terminals.size());
+
+            m_pendingTerminals.clear();
+            if (accepted) {
+                out << m_pendingText;
+                states.swap(trial);
+                savedStack = stack;
+                savedFillAssigned = m_fillAssigned;
+                retries = 0;
+                m_pendingText.clear();
+                if (stack.empty()) break;
+            }
+            else {
+                m_pendingText.clear();
+                if (++retries > MAX_RETRIES) {
+                    std::cerr << "[SentenceGen] The LR table keeps rejecting generated text, giving up." << std::endl;
+                    return false;
+                }
+                stack = savedStack;
+                m_fillAssigned = savedFillAssigned;
+                continue;
+            }
+        }
+
+        Frame frame = stack.back();
+        stack.pop_back();
+
+        if (frame.kind == Frame::SYMBOL) {
+            if (frame.symbol < 0) emitTerminal(-frame.symbol - 1);
+            else expand(frame.symbol, frame.depth, stack);
+            continue;
+        }
+
+        // 重复帧：左递归 A => base x x x，右递归 A => x x x base
+        const Nonterminal& nt = m_nonterminals[frame.symbol];
+        bool more = frame.fill ? out.bytesWritten() < m_options.targetBytes : frame.remaining > 0;
+        if (more) {
+            if (!frame.fill) frame.remaining--;
+            stack.push_back(frame);
+            const std::vector<int>& choices = frame.kind == Frame::REPEAT_LEFT ? nt.lefts : nt.rights;
+            const Production& production = m_productions[choices[m_random() % choices.size()]];
+            if (frame.kind == Frame::REPEAT_LEFT) {
+                pushSymbols(production.rhs, 1, production.rhs.size(), frame.depth + 1, stack);
+            }
+            else {
+                pushSymbols(production.rhs, 0, production.rhs.size() - 1, frame.depth + 1, stack);
+            }
+        }
+        else if (frame.kind == Frame::REPEAT_RIGHT) {
+            const Production& base = m_productions[chooseBase(nt, frame.depth)];
+            pushSymbols(base.rhs, 0, base.rhs.size(), frame.depth + 1, stack);
+        }
+    }
+
+    if (out.bytesWritten() < m_options.targetBytes) {
+        std::cout << "[SentenceGen] Note: grammar has no repeatable list at the top, output is "
+                  << out.bytesWritten() << " bytes." << std::endl;
+    }
+    return true;
+}
+
+void SentenceGenerator::expand(int nonterminal, int depth, std::vector<Frame>& stack) {
+    const Nonterminal& nt = m_nonterminals[nonterminal];
+    if (!nt.lefts.empty() || !nt.rights.empty()) {
+        Frame frame;
+        frame.kind = !nt.lefts.empty() ? Frame::REPEAT_LEFT : Frame::REPEAT_RIGHT;
+        frame.symbol = nonterminal;
+        frame.depth = depth;
+        // 第一个遇到的列表负责把输出撑到目标大小
+        frame.fill = !m_fillAssigned;
+        m_fillAssigned = true;
+        frame.remaining = frame.fill ? 0 : chooseRepeat(depth);
+        stack.push_back(frame);
+        // 右递归的基础部分在重复结束后才展开
+        if (frame.kind == Frame::REPEAT_RIGHT) return;
+    }
+    const Production& base = m_productions[chooseBase(nt, depth)];
+    pushSymbols(base.rhs, 0, base.rhs.size(), depth + 1, stack);
+}
+
+// 只在深度上限内能终结的产生式中选，权重为剩余的深度余量；都不满足时退回最矮的产生式
+int SentenceGenerator::chooseBase(const Nonterminal& nt, int depth) {
+    long long total = 0;
+    for (int index : nt.bases) {
+        long long slack = (long long)m_options.maxDepth - depth - m_productions[index].height + 1;
+        if (slack > 0) total += slack;
+    }
+    if (total == 0) {
+        for (int index : nt.bases) {
+            if (m_productions[index].height == nt.height) return index;
+        }
+    }
+
+    long long pick = (long long)(m_random() % (unsigned long long)total);
+    for (int index : nt.bases) {
+        long long slack = (long long)m_options.maxDepth - depth - m_productions[index].height + 1;
+        if (slack <= 0) continue;
+        if (pick < slack) return index;
+        pick -= slack;
+    }
+    return nt.bases.back();
+}
+
+// 内层列表的重复次数：几何分布，均值随深度线性减小，到达深度上限时为 0
+unsigned long long SentenceGenerator::chooseRepeat(int depth) {
+    if (depth >= m_options.maxDepth) return 0;
+    double mean = m_options.meanRepeat * (m_options.maxDepth - depth) / m_options.maxDepth;
+    std::geometric_distribution<int> distribution(1.0 / (1.0 + mean));
+    return (unsigned long long)distribution(m_random);
+}
+
+void SentenceGenerator::pushSymbols(const std::vector<int>& symbols, size_t begin, size_t end, int depth, std::vector<Frame>& stack) {
+    for (size_t i = end; i > begin; --i) {
+        Frame frame;
+        frame.kind = Frame::SYMBOL;
+        frame.symbol = symbols[i - 1];
+        frame.depth = depth;
+        frame.remaining = 0;
+        frame.fill = false;
+        stack.push_back(frame);
+    }
+}
+
+// 写出一个词素和分隔符；词素结束的状态不能再吃进分隔符，否则最长匹配会把两者连在一起
+void SentenceGenerator::emitTerminal(int terminal) {
+    const std::string* separator = &m_separator;
+    const Terminal& t = m_terminals[terminal];
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        int endState;
+        if (!t.keyword.empty()) {
+            m_lexeme = t.keyword;
+            endState = t.keywordState;
+        }
+        else {
+            // 与关键字相同的词素会被改判为关键字，重新采样
+            endState = sampleLexeme(t, m_lexeme);
+            for (int retry = 0; retry < 64 && m_keywordTexts.count(m_lexeme); ++retry) {
+                endState = sampleLexeme(t, m_lexeme);
+            }
+        }
+        char last = m_lexeme.back();
+        separator = (last == ';' || last == '{' || last == '}') ? &m_lineSeparator : &m_separator;
+        if (separator->empty() || findTransition(m_dfa[endState].transitions, (unsigned char)(*separator)[0]) < 0) break;
+    }
+    m_pendingText += m_lexeme;
+    m_pendingText += *separator;
+    m_pendingTerminals.push_back(terminal);
+}
+
+// 从起始状态随机游走到该 Token 的终态，词素写入 text，返回结束的状态
+int SentenceGenerator::sampleLexeme(const Terminal& terminal, std::string& text) {
+    text.clear();
+    int state = 0;
+    while (true) {
+        // 超过软上限后只走离终态更近的转移
+        bool limited = text.size() >= LEXEME_SOFT_LIMIT;
+        const std::vector<CharRange>& moves = limited ? terminal.closer[state] : terminal.reachable[state];
+        if (terminal.distance[state] == 0 && (moves.empty() || limited || (m_random() & 1))) break;
+
+        // 所有区间中的字符等概率：先抽字符序号，再找到它所在的区间
+        unsigned int width = 0;
+        for (const auto& move : moves) width += move.high - move.low + 1u;
+        unsigned int pick = (unsigned int)(m_random() % width);
+        for (const auto& move : moves) {
+            unsigned int size = move.high - move.low + 1u;
+            if (pick < size) {
+                text += (char)(move.low + pick);
+                state = move.target;
+                break;
+            }
+            pick -= size;
+        }
+    }
+    return state;
+}
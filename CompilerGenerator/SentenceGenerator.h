@@ -0,0 +1,134 @@
+#pragma once
+
+#include "Types.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <random>
+
+class OutputSink;
+
+// 随机程序生成选项 (由命令行决定)
+struct SentenceOptions {
+    unsigned long long targetBytes = 1 << 20; // 目标大小；达到后最外层列表停止重复，尽快收尾
+    int maxDepth = 16;                        // 推导深度上限 (列表重复不计入深度)
+    double meanRepeat = 2.0;                  // 内层列表的平均重复次数，越深越少
+    unsigned long long seed = 1;
+};
+
+// 按文法随机生成语法正确的程序，用作压测语料
+// - 每个非终结符预先算出最小推导高度；选产生式时只考虑能在深度上限内终结的，
+//   剩余深度越小越偏向矮的产生式，保证推导一定结束
+// - 左递归 (A -> A x) 与右递归 (A -> x A) 的产生式不逐层展开，而是化为 "基础产生式 + 重复 k 次"，
+//   最外层的那个列表一直重复到输出达到目标大小
+// - 终结符的词素在最小化 DFA 上随机游走得到，保证词法分析器会把它识别为同一个 Token
+// - 文法有冲突时 (如悬空 else)，LR 表接受的语言比文法小：最外层列表每重复一次，
+//   就用 ACTION/GOTO 表校验这一段，不接受则回到上一个校验点重新生成
+// - 输出按段写入带缓冲的 OutputSink，内存只与一段的大小有关，可以生成任意大小的语料
+class SentenceGenerator {
+public:
+    // rules: ParserGenerator::getRules() 的增广产生式 (第 0 条的左部为起始符号)，
+    // actionTbl / gotoTbl 为同一次构建得到的 LR 表
+    SentenceGenerator(const std::vector<ProductionRule>& rules, const DFATable& dfa,
+                      const ActionTable& actionTbl, const GotoTable& gotoTbl);
+
+    void setOptions(const SentenceOptions& opts) { m_options = opts; }
+
+    // 不在 DFA 中的关键字 (LexerGenerator::getKeywords())：关键字 Token 直接写出字面串，
+    // 覆盖它们的规则 (如 ID) 采样时避开这些字面串
+    void setKeywords(const std::vector<KeywordDefinition>& keywords) { m_keywords = keywords; }
+
+    // 建立生成所需的表；文法中有不能终结的非终结符或 DFA 采不到的终结符时报错并返回 false
+    bool prepare();
+
+    // 生成一个程序写入 out / 文件
+    bool generate(OutputSink& out);
+    bool generateFile(const std::string& path);
+
+private:
+    static const int INF_HEIGHT = 1 << 29;
+
+    // 符号编码：>= 0 为非终结符下标，< 0 为终结符 -(下标 + 1)
+    struct Production {
+        int lhs;
+        std::vector<int> rhs;
+        int height; // 完全展开所需的最小高度
+    };
+
+    struct Nonterminal {
+        std::string name;
+        std::vector<int> bases;  // 非直接递归的产生式
+        std::vector<int> lefts;  // A -> A x
+        std::vector<int> rights; // A -> x A
+        int height;
+    };
+
+    struct Terminal {
+        std::string name;
+        std::vector<int> distance; // 每个 DFA 状态到该 Token 终态的最短距离，-1 为不可达
+        // 每个状态上仍能到达终态的转移，以及其中离终态更近的转移 (采样时按区间宽度加权挑选字符)
+        std::vector<std::vector<CharRange>> reachable;
+        std::vector<std::vector<CharRange>> closer;
+        std::string keyword;  // 关键字 Token 的字面串，其余为空
+        int keywordState;     // 关键字字面串在 DFA 中结束的状态
+    };
+
+    // 工作栈中的一项
+    struct Frame {
+        enum Kind { SYMBOL, REPEAT_LEFT, REPEAT_RIGHT } kind;
+        int symbol;                     // SYMBOL: 待展开的符号；REPEAT_*: 重复的非终结符
+        int depth;
+        unsigned long long remaining;   // REPEAT_*: 还要重复的次数
+        bool fill;                      // REPEAT_*: 重复到输出达到目标大小为止
+    };
+
+    void computeHeights();
+    bool buildTerminal(Terminal& terminal);
+    bool pickSeparators();
+    void buildParseTables(const std::map<std::string, int>& nonterminalIds, const std::map<std::string, int>& terminalIds);
+    bool feed(std::vector<int>& states, int terminal) const;
+
+    void expand(int nonterminal, int depth, std::vector<Frame>& stack);
+    int chooseBase(const Nonterminal& nt, int depth);
+    unsigned long long chooseRepeat(int depth);
+    void pushSymbols(const std::vector<int>& symbols, size_t begin, size_t end, int depth, std::vector<Frame>& stack);
+    void emitTerminal(int terminal);
+    int sampleLexeme(const Terminal& terminal, std::string& text);
+    int run(int state, const std::string& text) const;
+
+    const std::vector<ProductionRule>& m_rules;
+    const DFATable& m_dfa;
+    const ActionTable& m_actionTable;
+    const GotoTable& m_gotoTable;
+    SentenceOptions m_options;
+    std::vector<KeywordDefinition> m_keywords;
+    std::set<std::string> m_keywordTexts;
+    std::mt19937_64 m_random;
+
+    std::vector<Production> m_productions;
+    std::vector<Nonterminal> m_nonterminals;
+    std::vector<Terminal> m_terminals;
+
+    // 稠密的 ACTION / GOTO 表 (编码同生成的 Parser：0 出错，s+1 移进，-(r+1) 归约，-1 接受)；
+    // ACTION 的最后一列是结束标记
+    int m_stateCount;
+    std::vector<int> m_action;
+    std::vector<int> m_goto;
+    std::vector<int> m_ruleLength;
+    std::vector<int> m_ruleLhs;
+
+    // 尚未校验的一段输出
+    std::string m_pendingText;
+    std::vector<int> m_pendingTerminals;
+    std::string m_lexeme;
+
+    // DFA 中每个状态的可打印字符转移区间 (采样用)；状态均以 m_dfa 中的下标表示
+    std::map<int, int> m_stateIndex; // stateID -> 下标
+    std::vector<std::vector<CharRange>> m_moves;
+
+    // Token 之间的分隔符 (被识别为 SKIP 的空白)；lineSeparator 用在 ; { } 之后
+    std::string m_separator;
+    std::string m_lineSeparator;
+    bool m_fillAssigned;
+};
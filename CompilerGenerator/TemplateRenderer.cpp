@@ -0,0 +1,114 @@
+#include "TemplateRenderer.h"
+#include <iostream>
+#include <cstring>
+
+// ==========================================
+// OutputSink 实现
+// ==========================================
+
+OutputSink::OutputSink(const std::string& filepath, size_t bufferSize)
+    : m_file(filepath, std::ios::binary), m_buffer(bufferSize), m_used(0), m_written(0) {}
+
+OutputSink::~OutputSink() {
+    if (m_file.is_open()) {
+        close();
+    }
+}
+
+bool OutputSink::close() {
+    flush();
+    bool ok = !m_file.fail();
+    m_file.close();
+    return ok && !m_file.fail();
+}
+
+void OutputSink::flush() {
+    if (m_used > 0) {
+        m_file.write(m_buffer.data(), (std::streamsize)m_used);
+        m_written += m_used;
+        m_used = 0;
+    }
+}
+
+void OutputSink::write(const char* data, size_t size) {
+    if (m_used + size > m_buffer.size()) {
+        flush();
+        // 大块数据直接写入文件，不经过缓冲区
+        if (size > m_buffer.size()) {
+            m_file.write(data, (std::streamsize)size);
+            m_written += size;
+            return;
+        }
+    }
+    std::memcpy(m_buffer.data() + m_used, data, size);
+    m_used += size;
+}
+
+OutputSink& OutputSink::operator<<(const char* str) {
+    write(str, std::strlen(str));
+    return *this;
+}
+
+OutputSink& OutputSink::operator<<(char c) {
+    if (m_used == m_buffer.size()) flush();
+    m_buffer[m_used++] = c;
+    return *this;
+}
+
+// ==========================================
+// TemplateRenderer 实现
+// ==========================================
+
+// 占位符名只允许大写字母、数字和下划线，其余的 "{{" 按字面文本处理
+static bool isPlaceholderName(const std::string& name) {
+    if (name.empty()) return false;
+    for (char c : name) {
+        if (!((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_')) return false;
+    }
+    return true;
+}
+
+TemplateRenderer::TemplateRenderer(const std::string& text) {
+    Segment current;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t open = text.find("{{", pos);
+        if (open == std::string::npos) break;
+        size_t close = text.find("}}", open + 2);
+        if (close == std::string::npos) break;
+
+        std::string name = text.substr(open + 2, close - open - 2);
+        if (!isPlaceholderName(name)) {
+            current.literal.append(text, pos, open + 2 - pos);
+            pos = open + 2;
+            continue;
+        }
+
+        current.literal.append(text, pos, open - pos);
+        current.placeholder = name;
+        m_segments.push_back(current);
+        current = Segment();
+        pos = close + 2;
+    }
+    current.literal.append(text, pos, std::string::npos);
+    m_segments.push_back(current);
+}
+
+bool TemplateRenderer::render(OutputSink& out, const SectionMap& sections) const {
+    for (const auto& segment : m_segments) {
+        out << segment.literal;
+        if (segment.placeholder.empty()) continue;
+
+        auto it = sections.find(segment.placeholder);
+        if (it == sections.end()) {
+            std::cerr << "[TemplateRenderer] Missing section for placeholder {{" << segment.placeholder << "}}." << std::endl;
+            return false;
+        }
+        it->second(out);
+    }
+    return true;
+}
+
+TemplateRenderer::Section TemplateRenderer::text(const std::string& str) {
+    return [str](OutputSink& out) { out << str; };
+}
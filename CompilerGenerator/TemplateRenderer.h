@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <fstream>
+#include <type_traits>
+
+// 带缓冲的文件输出
+// 生成的代码先写入固定大小的内存缓冲区，满了再整块写入文件，避免先拼出整个文件再写
+class OutputSink {
+public:
+    explicit OutputSink(const std::string& filepath, size_t bufferSize = 1 << 16);
+    ~OutputSink();
+
+    bool isOpen() const { return m_file.is_open(); }
+
+    // 写出剩余缓冲并关闭文件，返回整个写入过程是否成功
+    bool close();
+
+    void write(const char* data, size_t size);
+
+    OutputSink& operator<<(const std::string& str) { write(str.data(), str.size()); return *this; }
+    OutputSink& operator<<(const char* str);
+    OutputSink& operator<<(char c);
+
+    // 整数 (char 除外，按字符写出)
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, char>::value, OutputSink&>::type
+    operator<<(T value) { return *this << std::to_string(value); }
+
+    // 已写出的总字节数
+    size_t bytesWritten() const { return m_written + m_used; }
+
+private:
+    void flush();
+
+    std::ofstream m_file;
+    std::vector<char> m_buffer;
+    size_t m_used;    // 缓冲区中待写出的字节数
+    size_t m_written; // 已写入文件的字节数
+};
+
+// 预先切分好的代码模板
+// 构造时把模板一次性切分为 "字面文本 + {{NAME}} 占位符" 的片段序列，
+// 渲染时顺序写出字面文本，遇到占位符则调用对应的生成函数直接写入输出，不再整体查找替换
+class TemplateRenderer {
+public:
+    // 占位符的生成函数：把该段代码写入 out
+    using Section = std::function<void(OutputSink&)>;
+    using SectionMap = std::map<std::string, Section>;
+
+    explicit TemplateRenderer(const std::string& text);
+
+    // 模板中有未提供的占位符时报错并返回 false
+    bool render(OutputSink& out, const SectionMap& sections) const;
+
+    // 辅助：固定文本的生成函数
+    static Section text(const std::string& str);
+
+private:
+    struct Segment {
+        std::string literal;     // 占位符之前的字面文本
+        std::string placeholder; // 占位符名 (不含大括号)，最后一段为空
+    };
+    std::vector<Segment> m_segments;
+};
@@ -11,6 +11,8 @@ const std::string TEMPLATE_LEXER_H = R"(
 
 #include <string>
 #include <iostream>
+#include <vector>
+#include <unordered_set>
 
 // Token 结构定义
 struct Token {
@@ -25,6 +27,9 @@ public:
     // 构造函数：接收源代码
     Lexer(const std::string& source);
 
+    // 换一份源代码从头开始扫描 (批处理时复用同一个 Lexer)
+    void reset(const std::string& source);
+
     // 获取下一个 Token
     Token nextToken();
 
@@ -35,6 +40,13 @@ private:
     std::string m_source; // 源代码
     size_t m_pos;         // 当前字符位置
     int m_line;           // 当前行号
+
+    // 最长匹配回退的记忆化 (LEXER_MEMOIZE_FAILURES=1 时使用)：
+    // m_failed 记录到不了终态的 (状态, 位置)，m_failedPath 为本次扫描在最后一个终态之后经过的 (状态, 位置)，
+    // m_failedEpoch 为记录对应的状态编号版本 (惰性 DFA 清空缓存后编号失效)
+    std::unordered_set<unsigned long long> m_failed;
+    std::vector<unsigned long long> m_failedPath;
+    unsigned long long m_failedEpoch;
     
     // 辅助：获取当前字符
     char peek() const;
@@ -47,9 +59,28 @@ private:
 
 const std::string TEMPLATE_LEXER_CPP = R"(
 #include "lexer.h"
+#include <cstdint>
 
+// LEXER_MEMOIZE_FAILURES=1 (默认) 时记录回退越过的 (状态, 位置)：从那里出发到不了任何终态，
+// 之后的扫描走到同一处立即停止，保证整个输入的词法分析是线性时间 (Reps 的记忆化最长匹配)；
+// 只有回退越过非终态时才会产生记录，没有这种情况的词法规则几乎没有额外开销
+#ifndef LEXER_MEMOIZE_FAILURES
+#define LEXER_MEMOIZE_FAILURES 1
+#endif
+{{KEYWORD_TABLES}}
+// ==========================================
+//  终态标记 (自动生成)
+// ==========================================
+{{ACCEPTING_STATES}}
 Lexer::Lexer(const std::string& source) 
-    : m_source(source), m_pos(0), m_line(1) {}
+    : m_source(source), m_pos(0), m_line(1), m_failedEpoch(0) {}
+
+void Lexer::reset(const std::string& source) {
+    m_source = source;
+    m_pos = 0;
+    m_line = 1;
+    m_failed.clear();
+}
 
 int Lexer::getLine() const {
     return m_line;
@@ -73,7 +104,7 @@ Token Lexer::nextToken() {
     // 如果匹配到了 SKIP，循环会继续，直到匹配到非 SKIP 或 EOF
     while (true) {
         
-        // 使用 Lambda 封装一次 DFA 贪婪匹配过程
+        // 使用 Lambda 封装一次 DFA 最长匹配过程
         auto matchOneToken = [&]() -> Token {
             // EOF 检查
             if (m_pos >= m_source.length()) {
@@ -81,11 +112,19 @@ Token Lexer::nextToken() {
             }
 
             int state = 0;       // 初始状态
-            std::string currentText;
+            size_t start = m_pos;
+
+            // 最近一次经过的终态：走到无路可走时回退到这里，回退是 O(1) 的
+            int lastAccept = -1;
+            size_t lastAcceptPos = start;
+            int lastAcceptLine = m_line;
+#if LEXER_MEMOIZE_FAILURES
+            m_failedPath.clear();
+#endif
             
             // 贪婪匹配循环
-            while (true) {
-                char c = peek(); 
+            while (m_pos < m_source.length()) {
+                unsigned char c = (unsigned char)peek(); 
                 int nextState = -1;
 
                 // ==========================================
@@ -98,29 +137,53 @@ Token Lexer::nextToken() {
                 }
                 // ==========================================
 
-                if (nextState != -1) {
-                    // 状态转移成功
-                    state = nextState;
-                    advance(); // 吃掉字符
-                    currentText += c; // 记录文本
-                } else {
-                    // 没路走了，根据当前停留在的状态决定 Token 类型
-                    
-                    // 1. 如果还在初始状态 0，说明遇到的第一个字符就是非法的
-                    if (state == 0) {
-                         // 移动指针避免死循环，并返回错误
-                         char errC = advance(); 
-                         return Token{"ERROR", std::string(1, errC), m_line};
-                    }
-
-                    // 2. 根据终态返回 Token 
-                    // (生成的代码包含 return 语句，这里会退出 Lambda)
-{{FINAL_STATE_JUDGEMENT}}
+                if (nextState == -1) break;
+#if LEXER_MEMOIZE_FAILURES
+                if (!m_failed.empty() && m_failed.count((unsigned long long)(m_pos + 1) * LEXER_STATE_COUNT + nextState)) break;
+#endif
 
-                    // 兜底：虽然走了很多步，但停在了一个非终态上
-                    return Token{"ERROR", "Unrecognized state: " + currentText, m_line};
+                // 状态转移成功
+                state = nextState;
+                advance(); // 吃掉字符
+                if (LEXER_ACCEPTING[state]) {
+                    lastAccept = state;
+                    lastAcceptPos = m_pos;
+                    lastAcceptLine = m_line;
+#if LEXER_MEMOIZE_FAILURES
+                    m_failedPath.clear();
+#endif
+                }
+#if LEXER_MEMOIZE_FAILURES
+                else {
+                    m_failedPath.push_back((unsigned long long)m_pos * LEXER_STATE_COUNT + state);
                 }
+#endif
+            }
+
+            // 1. 遇到的第一个字符就是非法的：移动指针避免死循环，并返回错误
+            if (m_pos == start) {
+                char errC = advance(); 
+                return Token{"ERROR", std::string(1, errC), m_line};
             }
+
+            // 2. 一路上没有经过终态
+            if (lastAccept < 0) {
+                return Token{"ERROR", "Unrecognized state: " + m_source.substr(start, m_pos - start), m_line};
+            }
+
+            // 3. 回退到最后一个终态，根据终态返回 Token
+            // (生成的代码包含 return 语句，这里会退出 Lambda)
+#if LEXER_MEMOIZE_FAILURES
+            m_failed.insert(m_failedPath.begin(), m_failedPath.end());
+#endif
+            m_pos = lastAcceptPos;
+            m_line = lastAcceptLine;
+            state = lastAccept;
+            std::string currentText = m_source.substr(start, m_pos - start);
+{{FINAL_STATE_JUDGEMENT}}
+
+            // 兜底：终态标记与终态判断不一致
+            return Token{"ERROR", "Unrecognized state: " + currentText, m_line};
         };
 
         // === 执行匹配 ===
@@ -139,6 +202,270 @@ Token Lexer::nextToken() {
 }
 )";
 
+// =========================================================
+// 2.0 关键字完美哈希查找 (接在 KEYWORD_TABLES 数据之后，两种 Lexer 共用)
+// =========================================================
+const std::string TEMPLATE_KEYWORD_MATCH = R"(
+// 两次哈希必须与生成器中的 keywordHash 一致 (带种子的 FNV-1a)
+inline uint32_t keywordHash(const std::string& text, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for (char c : text) {
+        h ^= (unsigned char)c;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// 词素等于某个关键字时返回关键字的 Token 名，否则返回 fallback (覆盖它的规则)
+inline const char* matchKeyword(const std::string& text, const char* fallback) {
+    if (text.size() < KEYWORD_MIN_LENGTH || text.size() > KEYWORD_MAX_LENGTH) return fallback;
+    uint32_t bucket = keywordHash(text, 0) % KEYWORD_BUCKET_COUNT;
+    uint32_t slot = keywordHash(text, KEYWORD_DISPLACEMENT[bucket]) % KEYWORD_SLOT_COUNT;
+    return text == KEYWORD_TEXT[slot] ? KEYWORD_TOKEN[slot] : fallback;
+}
+
+} // namespace
+)";
+
+// =========================================================
+// 2.1 惰性 DFA Lexer 实现模版 (lexer.cpp，DFA 状态超出上限时使用)
+// =========================================================
+const std::string TEMPLATE_LAZY_LEXER_CPP = R"(
+#include "lexer.h"
+#include <cstdint>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+// 惰性 DFA 缓存最多容纳的状态数；满了就整体清空，从当前位置重新按需构造
+#ifndef LEXER_DFA_CACHE_STATES
+#define LEXER_DFA_CACHE_STATES 4096
+#endif
+
+// 同 DFA 模式：记录回退越过的 (状态, 位置)，保证线性时间；缓存清空后状态编号失效，记录随之清空
+#ifndef LEXER_MEMOIZE_FAILURES
+#define LEXER_MEMOIZE_FAILURES 1
+#endif
+
+// ==========================================
+//  紧凑 NFA (自动生成)
+//  NFA_ACCEPT: 终态对应的规则下标 (越小优先级越高)，非终态为 -1
+//  NFA_EPSILON / NFA_MOVE_*: 按状态分段存放，第 s 个状态的转移在 [BEGIN[s], BEGIN[s + 1]) 内
+//  NFA_MOVE_LOW / NFA_MOVE_HIGH: 字符转移的区间 [LOW, HIGH]
+// ==========================================
+{{NFA_TABLES}}{{KEYWORD_TABLES}}
+namespace {
+
+// 惰性 DFA：DFA 状态即 NFA 状态集合的 epsilon 闭包，转移在第一次用到时才计算并缓存
+class LazyDFA {
+public:
+    static constexpr int UNKNOWN = -2;
+    static constexpr int DEAD = -1;
+
+    LazyDFA() : m_generation(0), m_mark(NFA_STATE_COUNT, 0) { flush(); m_generation = 0; }
+
+    int start() const { return m_start; }
+    // 每清空一次缓存加一
+    unsigned long long generation() const { return m_generation; }
+    int accept(int state) const { return m_states[state].accept; }
+
+    int next(int state, unsigned char c) {
+        int target = m_states[state].next[c];
+        return target != UNKNOWN ? target : computeNext(state, c);
+    }
+
+private:
+    struct State {
+        std::vector<int> nfaStates; // 排好序的 NFA 状态集合
+        int accept;
+        int next[256];
+    };
+
+    std::vector<State> m_states;
+    std::map<std::vector<int>, int> m_index;
+    int m_start;
+    unsigned long long m_generation;
+    std::vector<char> m_mark;
+    std::vector<int> m_work;
+
+    void flush() {
+        ++m_generation;
+        m_states.clear();
+        m_index.clear();
+        std::vector<int> set(1, NFA_START);
+        m_start = addState(closure(set));
+    }
+
+    std::vector<int> closure(std::vector<int> set) {
+        m_work.assign(set.begin(), set.end());
+        for (int s : set) m_mark[s] = 1;
+        while (!m_work.empty()) {
+            int s = m_work.back();
+            m_work.pop_back();
+            for (int i = NFA_EPSILON_BEGIN[s]; i < NFA_EPSILON_BEGIN[s + 1]; ++i) {
+                int t = NFA_EPSILON[i];
+                if (m_mark[t]) continue;
+                m_mark[t] = 1;
+                set.push_back(t);
+                m_work.push_back(t);
+            }
+        }
+        for (int s : set) m_mark[s] = 0;
+        std::sort(set.begin(), set.end());
+        return set;
+    }
+
+    int addState(std::vector<int> set) {
+        State state;
+        state.accept = -1;
+        for (int s : set) {
+            if (NFA_ACCEPT[s] >= 0 && (state.accept < 0 || NFA_ACCEPT[s] < state.accept)) state.accept = NFA_ACCEPT[s];
+        }
+        std::fill(state.next, state.next + 256, UNKNOWN);
+        int id = (int)m_states.size();
+        m_index[set] = id;
+        state.nfaStates = std::move(set);
+        m_states.push_back(std::move(state));
+        return id;
+    }
+
+    int computeNext(int state, unsigned char c) {
+        std::vector<int> moved;
+        for (int s : m_states[state].nfaStates) {
+            for (int i = NFA_MOVE_BEGIN[s]; i < NFA_MOVE_BEGIN[s + 1]; ++i) {
+                if (NFA_MOVE_LOW[i] <= c && c <= NFA_MOVE_HIGH[i]) moved.push_back(NFA_MOVE_TARGET[i]);
+            }
+        }
+        if (moved.empty()) {
+            m_states[state].next[c] = DEAD;
+            return DEAD;
+        }
+
+        std::vector<int> set = closure(std::move(moved));
+        auto it = m_index.find(set);
+        if (it != m_index.end()) {
+            m_states[state].next[c] = it->second;
+            return it->second;
+        }
+        if (m_states.size() >= LEXER_DFA_CACHE_STATES) {
+            // 缓存已满：整体清空。调用方只持有当前状态，换成返回的新编号继续即可
+            flush();
+            return addState(std::move(set));
+        }
+        int target = addState(std::move(set));
+        m_states[state].next[c] = target;
+        return target;
+    }
+};
+
+// 记忆化时 (状态, 位置) 的编码：位置 * LAZY_STATE_KEYS + 状态 (状态编号不超过缓存容量)
+const unsigned long long LAZY_STATE_KEYS = LEXER_DFA_CACHE_STATES + 1;
+
+// 缓存只依赖 NFA，同一线程内的所有 Lexer 共用一份
+LazyDFA& lazyDFA() {
+    thread_local LazyDFA dfa;
+    return dfa;
+}
+
+} // namespace
+
+Lexer::Lexer(const std::string& source) 
+    : m_source(source), m_pos(0), m_line(1), m_failedEpoch(0) {}
+
+void Lexer::reset(const std::string& source) {
+    m_source = source;
+    m_pos = 0;
+    m_line = 1;
+    m_failed.clear();
+}
+
+int Lexer::getLine() const {
+    return m_line;
+}
+
+char Lexer::peek() const {
+    if (m_pos >= m_source.length()) return '\0';
+    return m_source[m_pos];
+}
+
+char Lexer::advance() {
+    if (m_pos >= m_source.length()) return '\0';
+    char c = m_source[m_pos];
+    m_pos++;
+    if (c == '\n') m_line++;
+    return c;
+}
+
+Token Lexer::nextToken() {
+    LazyDFA& dfa = lazyDFA();
+
+    // 与 DFA 模式相同：最长匹配，回退到最后一个终态，SKIP 继续扫描
+    while (true) {
+        if (m_pos >= m_source.length()) {
+            return Token{"#", "", m_line};
+        }
+
+        int state = dfa.start();
+        size_t start = m_pos;
+        int lastRule = -1;
+        size_t lastAcceptPos = start;
+        int lastAcceptLine = m_line;
+#if LEXER_MEMOIZE_FAILURES
+        m_failedPath.clear();
+#endif
+        while (m_pos < m_source.length()) {
+            int nextState = dfa.next(state, (unsigned char)peek());
+#if LEXER_MEMOIZE_FAILURES
+            if (dfa.generation() != m_failedEpoch) {
+                m_failed.clear();
+                m_failedPath.clear();
+                m_failedEpoch = dfa.generation();
+            }
+#endif
+            if (nextState == LazyDFA::DEAD) break;
+#if LEXER_MEMOIZE_FAILURES
+            if (!m_failed.empty() && m_failed.count((m_pos + 1) * LAZY_STATE_KEYS + nextState)) break;
+#endif
+            state = nextState;
+            advance();
+            if (dfa.accept(state) >= 0) {
+                lastRule = dfa.accept(state);
+                lastAcceptPos = m_pos;
+                lastAcceptLine = m_line;
+#if LEXER_MEMOIZE_FAILURES
+                m_failedPath.clear();
+#endif
+            }
+#if LEXER_MEMOIZE_FAILURES
+            else {
+                m_failedPath.push_back(m_pos * LAZY_STATE_KEYS + state);
+            }
+#endif
+        }
+
+        if (m_pos == start) {
+            char errC = advance();
+            return Token{"ERROR", std::string(1, errC), m_line};
+        }
+        if (lastRule < 0) {
+            return Token{"ERROR", "Unrecognized state: " + m_source.substr(start, m_pos - start), m_line};
+        }
+#if LEXER_MEMOIZE_FAILURES
+        m_failed.insert(m_failedPath.begin(), m_failedPath.end());
+#endif
+        m_pos = lastAcceptPos;
+        m_line = lastAcceptLine;
+        if (NFA_TOKEN_NAMES[lastRule] == std::string("SKIP")) {
+            continue;
+        }
+        std::string currentText = m_source.substr(start, m_pos - start);
+        const char* type = NFA_TOKEN_NAMES[lastRule];
+        if (NFA_KEYWORD_COVER[lastRule]) type = matchKeyword(currentText, type);
+        return Token{type, currentText, m_line};
+    }
+}
+)";
+
 // =========================================================
 // 3. Parser 头文件模版 (Parser.h)
 // =========================================================
@@ -149,30 +476,329 @@ const std::string TEMPLATE_PARSER_H = R"(
 #include "lexer.h"
 #include <vector>
 #include <string>
-#include <stack>
+#include <string_view>
+#include <variant>
+#include <utility>
+#include <new>
+#include <cstddef>
+#include <memory_resource>
+#include <unordered_map>
+#include <memory>
 #include <iostream>
 #include <algorithm> // 用于合并列表
 
+// --- 调试跟踪：编译时选择级别，默认完全编译掉 ---
+// PARSER_TRACE  0: 关闭  1: 打印归约  2: 打印归约与移进
+#ifndef PARSER_TRACE
+#define PARSER_TRACE 0
+#endif
+
+#if PARSER_TRACE > 0
+#define PARSER_TRACE_LOG(level, message) \
+    do { if ((level) <= PARSER_TRACE) *m_err << message << '\n'; } while (0)
+#else
+#define PARSER_TRACE_LOG(level, message) do {} while (0)
+#endif
+
+// --- 性能剖析：PARSER_PROFILE=1 时统计每条规则的归约次数、每个状态的访问次数与最大栈深 ---
+// 每次 parse() 结束时以 JSON 写入 setProfileStream() 给出的流；未设置时写入文件 PARSER_PROFILE_PATH
+#ifndef PARSER_PROFILE
+#define PARSER_PROFILE 0
+#endif
+#ifndef PARSER_PROFILE_PATH
+#define PARSER_PROFILE_PATH "parser_profile.json"
+#endif
+
+// --- 流水线模式：PARSER_PIPELINE=1 时词法分析在独立线程中提前运行 ---
+// Token 通过有界的单生产者/单消费者无锁环形队列交给 Parser，Parser 每次批量取出
+#ifndef PARSER_PIPELINE
+#define PARSER_PIPELINE {{PIPELINE_DEFAULT}}
+#endif
+#ifndef PARSER_TOKEN_RING_SIZE
+#define PARSER_TOKEN_RING_SIZE 4096 // 必须是 2 的幂
+#endif
+#ifndef PARSER_TOKEN_BATCH
+#define PARSER_TOKEN_BATCH 64
+#endif
+
+#if PARSER_PIPELINE
+#include <atomic>
+#include <thread>
+
+// SPSC 环形队列：head 只由消费者写，tail 只由生产者写
+// 双方各自缓存对方的下标，只有缓存显示满/空时才重新读取原子变量
+template <typename T, size_t Capacity>
+class TokenRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "TokenRing capacity must be a power of two");
+public:
+    TokenRing() : m_slots(new T[Capacity]) {}
+
+    // 生产者：放入一个元素，队列满时返回 false
+    bool tryPush(T&& value) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead == Capacity) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead == Capacity) return false;
+        }
+        m_slots[tail & (Capacity - 1)] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 消费者：最多取出 maxCount 个元素，返回实际取出的个数
+    size_t tryPopBatch(T* out, size_t maxCount) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail) return 0;
+        }
+        size_t count = std::min(maxCount, m_cachedTail - head);
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = std::move(m_slots[(head + i) & (Capacity - 1)]);
+        }
+        m_head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    // 只能在两端线程都停止后调用
+    void clear() {
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+        m_cachedHead = 0;
+        m_cachedTail = 0;
+    }
+
+private:
+    std::unique_ptr<T[]> m_slots;
+    alignas(64) std::atomic<size_t> m_head{ 0 }; // 消费者位置
+    size_t m_cachedTail = 0;                      // 消费者缓存的 tail
+    alignas(64) std::atomic<size_t> m_tail{ 0 }; // 生产者位置
+    size_t m_cachedHead = 0;                      // 生产者缓存的 head
+};
+#endif
+
+// 文法规模 (生成时确定)
+const int PARSER_RULE_COUNT = {{RULE_COUNT}};
+const int PARSER_STATE_COUNT = {{STATE_COUNT}};
+const int PARSER_TERMINAL_COUNT = {{TERMINAL_COUNT}};
+const int PARSER_NONTERMINAL_COUNT = {{NONTERMINAL_COUNT}};
+
+// --- 分析表：只读数据，定义在表数据部分 (可能是单独的编译单元)，所有 Parser 实例共享 ---
+// ACTION 表项: 0 出错；s + 1 移进到状态 s；-(r + 1) 按规则 r 归约 (规则 0 即接受)
+using ParserTableEntry = {{TABLE_ENTRY_TYPE}};
+extern const ParserTableEntry PARSER_ACTION[];    // 下标: state * PARSER_TERMINAL_COUNT + 终结符编号
+extern const char* const PARSER_TERMINAL_NAMES[]; // 终结符名，按字典序排列，下标即编号
+extern const ParserTableEntry PARSER_RULE_LENGTH[]; // 规则右部长度
+extern const ParserTableEntry PARSER_RULE_LHS[];    // 规则左部的非终结符编号
+extern const char* const PARSER_RULE_NAMES[];     // 规则的可读形式 (跟踪与剖析用)
+
+// GOTO 表 (压缩存储，同 yacc 的 yydefgoto/yypgoto)
+// 每个非终结符取出现最多的目标状态作为默认值，其余作为例外
+// 按基址 PARSER_GOTO_BASE[nt] 错位存入共享的 PARSER_GOTO_NEXT 数组，PARSER_GOTO_CHECK 记录所属状态
+extern const int PARSER_GOTO_TABLE_SIZE;
+extern const ParserTableEntry PARSER_GOTO_DEFAULT[];
+extern const int PARSER_GOTO_BASE[];
+extern const ParserTableEntry PARSER_GOTO_CHECK[];
+extern const ParserTableEntry PARSER_GOTO_NEXT[];
+
+)"
+// (MSVC 单个字符串字面量长度有限，模板分段拼接)
+R"(// --- 连续存储的解析栈 ---
+// 前 InlineCapacity 个元素放在对象内部的缓冲区中，超出后整体搬到堆上 (容量翻倍)
+// 归约时通过 slots(n) 直接访问栈顶 n 个元素 (类似 yacc 的 yyvsp[n - len])
+template <typename T, size_t InlineCapacity>
+class ParseStack {
+public:
+    ParseStack() : m_data(inlineBuffer()), m_size(0), m_capacity(InlineCapacity) {}
+    ~ParseStack() {
+        clear();
+        if (m_data != inlineBuffer()) ::operator delete(m_data);
+    }
+    ParseStack(const ParseStack&) = delete;
+    ParseStack& operator=(const ParseStack&) = delete;
+
+    void push(T&& value) {
+        if (m_size == m_capacity) grow();
+        new (m_data + m_size) T(std::move(value));
+        ++m_size;
+    }
+    void push(const T& value) {
+        if (m_size == m_capacity) grow();
+        new (m_data + m_size) T(value);
+        ++m_size;
+    }
+
+    T& top() { return m_data[m_size - 1]; }
+    const T& top() const { return m_data[m_size - 1]; }
+
+    // 栈顶 n 个元素的首地址 (slots(n)[0] 是其中最深的那个)
+    T* slots(size_t n) { return m_data + (m_size - n); }
+
+    // 一次弹出 n 个元素
+    void popN(size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            m_data[--m_size].~T();
+        }
+    }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    void clear() { popN(m_size); }
+
+private:
+    alignas(T) unsigned char m_inline[sizeof(T) * InlineCapacity];
+    T* m_data;
+    size_t m_size;
+    size_t m_capacity;
+
+    T* inlineBuffer() { return reinterpret_cast<T*>(m_inline); }
+
+    void grow() {
+        size_t newCapacity = m_capacity * 2;
+        T* newData = static_cast<T*>(::operator new(sizeof(T) * newCapacity));
+        for (size_t i = 0; i < m_size; ++i) {
+            new (newData + i) T(std::move(m_data[i]));
+            m_data[i].~T();
+        }
+        if (m_data != inlineBuffer()) ::operator delete(m_data);
+        m_data = newData;
+        m_capacity = newCapacity;
+    }
+};
+
+// --- 单次解析使用的单调内存池 (Arena) ---
+// 语义值、临时变量名、回填列表与代码缓冲区都从这里分配
+// 单个释放是空操作；下一次 parse() 开始或 Parser 析构时整块归还
+struct ArenaStats {
+    size_t allocations = 0;    // 分配次数
+    size_t bytesRequested = 0; // 请求的字节数
+    size_t bytesReserved = 0;  // 向系统申请的块总大小
+    size_t blocks = 0;         // 块数
+};
+
+class ParseArena : public std::pmr::memory_resource {
+public:
+    explicit ParseArena(size_t firstBlockSize = 16 * 1024);
+    ~ParseArena() override;
+    ParseArena(const ParseArena&) = delete;
+    ParseArena& operator=(const ParseArena&) = delete;
+
+    // 归还所有块 (保留第一块供下次复用)，统计清零
+    void release();
+    const ArenaStats& stats() const { return m_stats; }
+
+private:
+    struct Block {
+        Block* prev;
+        size_t size;
+    };
+
+    Block* m_head;
+    char* m_cursor;
+    char* m_end;
+    size_t m_firstBlockSize;
+    size_t m_nextBlockSize;
+    ArenaStats m_stats;
+
+    void addBlock(size_t minBytes);
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+// 分配在 Arena 上的字符串
+using ArenaString = std::pmr::string;
+
+// --- 三地址码操作码 ---
+enum Opcode : unsigned char {
+    OP_NOP,
+    OP_ASSIGN,                   // result = arg1
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, // result = arg1 op arg2
+    OP_JLT, OP_JGT, OP_JEQ,      // if arg1 relop arg2 goto result
+    OP_GOTO,                     // goto result
+    OP_PRINT,                    // print arg1
+    OP_PARAM,                    // param arg1
+    OP_CALL,                     // result = call arg1
+    OP_RET,                      // ret arg1
+    OP_FUNC_BEGIN,               // begin_func arg1, param=arg2
+    OP_FUNC_END,                 // end_func
+    OP_TEXT,                     // arg1 为驻留的指令文本，原样输出；result 非空时在末尾追加跳转目标
+                                 // 内置操作码之外的指令 (!=、%、取负、数组下标等) 都可以用它表示
+};
+
+// --- 操作数：种类 + 整数编号 ---
+// 名字 (标识符、常量) 经过驻留只存编号；临时变量与标签只存序号；渲染时才生成文本
+enum OperandKind : unsigned char {
+    OPD_NONE,    // 空
+    OPD_NAME,    // 驻留的名字，index 为名字表下标
+    OPD_TEMP,    // 临时变量 t<index>
+    OPD_LABEL,   // 标签 L<index>
+    OPD_QUAD,    // 指令编号 (跳转目标)
+    OPD_PENDING, // 待回填的跳转，index 为回填链表中的下一条指令
+};
+
+struct Operand {
+    OperandKind kind = OPD_NONE;
+    int index = 0;
+
+    bool empty() const { return kind == OPD_NONE; }
+    static Operand quad(int target) { return Operand{ OPD_QUAD, target }; }
+};
+
+// --- 四元式 (op, arg1, arg2, result) ---
+struct Quad {
+    Opcode op = OP_NOP;
+    Operand arg1;
+    Operand arg2;
+    Operand result;
+};
+
+using CodeBuffer = std::pmr::vector<Quad>;
+
+// --- 回填链表 (Backpatch List) ---
+// 待回填的跳转指令通过自身的 result 字段串成一个环形链表，列表本身只记录链尾
+// 链尾指向链头，因此合并只需交换两个链尾的后继 (O(1))
+struct PatchList {
+    int tail = -1; // -1 表示空列表
+    bool empty() const { return tail < 0; }
+};
+
+// --- 终结符的语义值：只携带词素与行号 ---
+struct TokenValue {
+    ArenaString text;
+    int line;
+
+    TokenValue(std::string_view t, int l, std::pmr::memory_resource* arena) : text(t, arena), line(l) {}
+};
+
 // --- 核心：语义值结构体 (Semantic Value) ---
+// 没有 %type 声明的非终结符使用这个完整结构
 struct SemanticValue {
-    std::string text;       
-    int line;               
+    ArenaString text;
+    int line;
 
     // SDT 属性
-    std::string code = "";       
-    std::string var = "";        
-    
+    ArenaString code;
+    Operand var;
+
     // 回填 (Backpatching) 专用属性
-    std::vector<int> trueList;   
-    std::vector<int> falseList;  
-    std::vector<int> nextList;   
-    
+    PatchList trueList;
+    PatchList falseList;
+    PatchList nextList;
+
     int quad = 0; // M 标记用
     int val = 0;
 
-    SemanticValue(std::string t = "", int l = 0) : text(t), line(l) {}
+    explicit SemanticValue(std::pmr::memory_resource* arena)
+        : text(arena), line(0), code(arena) {}
 };
 
+// --- 由 %type 声明生成的精简语义值 (只含所需字段) ---
+{{VALUE_TYPES}}
+// 值栈槽位：每个槽位只保存其符号对应的那一种类型
+using StackValue = std::variant<{{STACK_VALUE_TYPES}}>;
+
 class Parser {
 public:
     Parser(Lexer& lexer);
@@ -183,34 +809,112 @@ public:
     // 打印最终生成的代码
     void printGeneratedCode() const;
 
-    // 获取生成的代码缓冲区 (如果外部需要)
-    const std::vector<std::string>& getCodeBuffer() const { return m_codeBuffer; }
+    // 重定向生成代码与错误信息的输出 (默认 std::cout / std::cerr)
+    // 多个 Parser 并行工作时，各自使用独立的流即可互不干扰
+    void setOutputStreams(std::ostream& out, std::ostream& err);
+
+    // 剖析数据的输出流 (PARSER_PROFILE=1 时有效)；nullptr 表示写入文件 PARSER_PROFILE_PATH
+    // 同一进程中有多个 Parser 时应各自设置，否则它们会覆盖同一个文件
+    void setProfileStream(std::ostream* profile);
+
+    // 将四元式渲染为文本写出 (文本只在这里生成)
+    void writeCode(std::ostream& os) const;
+    std::string operandText(Operand operand) const;
+
+    // 获取生成的四元式 (如果外部需要；在下一次 parse() 之前有效)
+    const CodeBuffer& getCodeBuffer() const { return m_codeBuffer; }
+    int getCodeSize() const { return m_nextQuad; }
+
+    // Arena 分配统计
+    const ArenaStats& getArenaStats() const { return m_arena.stats(); }
+    void printArenaStats(std::ostream& os) const;
+
+    // 最近一次解析的移进 / 归约次数 (吞吐量统计用)
+    unsigned long long getShiftCount() const { return m_shiftCount; }
+    unsigned long long getReductionCount() const { return m_reductionCount; }
+
+#if PARSER_PROFILE
+    // 以 JSON 输出最近一次解析的剖析数据
+    void dumpProfile(std::ostream& os) const;
+#endif
 
 private:
+#if PARSER_PROFILE
+    struct ParseProfile {
+        unsigned long long shifts = 0;
+        unsigned long long reductions = 0;
+        size_t maxStackDepth = 0;
+        std::vector<unsigned long long> ruleReduces = std::vector<unsigned long long>(PARSER_RULE_COUNT);
+        std::vector<unsigned long long> stateVisits = std::vector<unsigned long long>(PARSER_STATE_COUNT);
+    };
+    ParseProfile m_profile;
+#endif
+
+    // Arena 必须先于使用它的容器构造、后于它们析构
+    ParseArena m_arena;
+
     Lexer& m_lexer;
-    std::stack<int> m_stateStack;           
-    std::stack<SemanticValue> m_valueStack; 
+#if PARSER_PIPELINE
+    // 词法线程与 Token 队列；m_tokenBatch 是 Parser 本地的批量缓冲
+    TokenRing<Token, PARSER_TOKEN_RING_SIZE> m_tokenRing;
+    std::thread m_lexerThread;
+    std::atomic<bool> m_stopLexer{ false };
+    Token m_tokenBatch[PARSER_TOKEN_BATCH];
+    size_t m_batchPos = 0;
+    size_t m_batchCount = 0;
+#endif
+    std::ostream* m_out;
+    std::ostream* m_err;
+    std::ostream* m_profileOut;
+    ParseStack<int, 256> m_stateStack;
+    ParseStack<StackValue, 64> m_valueStack;
+    unsigned long long m_shiftCount;
+    unsigned long long m_reductionCount;
 
     // --- 中间代码生成器状态 (原全局变量) ---
-    std::vector<std::string> m_codeBuffer; // 代码缓冲区
-    int m_tempCount;                       // 临时变量计数
-    int m_labelCount;                      // 标签计数
+    CodeBuffer m_codeBuffer; // 代码缓冲区
+    int m_nextQuad;          // 下一条指令的编号 (makelist 可能提前占用后续槽位)
+    int m_tempCount;         // 临时变量计数
+    int m_labelCount;        // 标签计数
+
+    // --- 名字驻留表：名字文本存放在 Arena 中，地址稳定 ---
+    std::pmr::vector<std::string_view> m_names;
+    std::pmr::unordered_map<std::string_view, int> m_nameIndex;
+
+    // --- 解析流程 ---
+    void reset();
+    bool parseLoop();
+    Token nextToken();
+#if PARSER_PIPELINE
+    void startLexerThread();
+    void stopLexerThread();
+#endif
 
     // --- 辅助函数：查表与报错 ---
-    int getGoto(int state, const std::string& lhs);
+    int getGoto(int state, int nonterminal);
     void reportError(const Token& token);
 
+    // --- 语义动作：每条规则一个函数 (函数体相同的规则共用)，可分散在多个编译单元中 ---
+    // rhs 指向右部各符号的值 (空产生式时指向 out)，结果写入 out (即左部所在的槽位)
+    // REDUCE_TABLE 按规则编号索引；没有动作的规则为 nullptr，归约时不做任何调用
+    using ReduceFn = void (Parser::*)(StackValue* rhs, StackValue& out);
+    static const ReduceFn REDUCE_TABLE[];
+{{ACTION_DECLS}}
+
     // --- 辅助函数：中间代码生成 (供语义动作调用) ---
     int nextquad() const;
-    std::string newTemp();
-    std::string newLabel();
-    void emit(const std::string& code);
+    Operand newTemp();
+    Operand newLabel();
+    Operand intern(std::string_view name);
+    void emit(Opcode op, Operand arg1 = {}, Operand arg2 = {}, Operand result = {});
+    void emit(std::string_view text); // 生成 OP_TEXT 指令，可以像内置跳转一样 makelist / backpatch
     
     // --- 辅助函数：回填逻辑 ---
-    std::vector<int> makelist(int index);
-    std::vector<int> merge(const std::vector<int>& list1, const std::vector<int>& list2);
-    void backpatch(const std::vector<int>& list, int targetQuad);
-    void backpatch(const std::vector<int>& list, const std::string& targetLabel);
+    PatchList makelist(int index);
+    PatchList merge(PatchList list1, PatchList list2);
+    void backpatch(PatchList list, int targetQuad);
+    void backpatch(PatchList list, Operand targetLabel);
+    Quad& codeSlot(int index);
 };
 
 #endif // GENERATED_PARSER_H
@@ -223,17 +927,114 @@ const std::string TEMPLATE_PARSER_CPP = R"(
 #include "parser.h"
 #include <sstream>
 #include <iomanip>
+#include <fstream>
+#include <cstdint>
+
+// 剖析计数：PARSER_PROFILE=0 时全部编译为空语句
+#if PARSER_PROFILE
+#define PARSER_PROFILE_VISIT(state) \
+    do { \
+        m_profile.stateVisits[state]++; \
+        if (m_stateStack.size() > m_profile.maxStackDepth) m_profile.maxStackDepth = m_stateStack.size(); \
+    } while (0)
+#define PARSER_PROFILE_SHIFT() (m_profile.shifts++)
+#define PARSER_PROFILE_REDUCE(rule) (m_profile.reductions++, m_profile.ruleReduces[rule]++)
+#else
+#define PARSER_PROFILE_VISIT(state) do {} while (0)
+#define PARSER_PROFILE_SHIFT() do {} while (0)
+#define PARSER_PROFILE_REDUCE(rule) do {} while (0)
+#endif
+
+// =========================================================
+//  Parser 类实现
+// =========================================================
+
+// ---------------------------------------------------------
+//  ParseArena：单调分配，块大小逐次翻倍
+// ---------------------------------------------------------
+
+ParseArena::ParseArena(size_t firstBlockSize)
+    : m_head(nullptr), m_cursor(nullptr), m_end(nullptr),
+      m_firstBlockSize(firstBlockSize), m_nextBlockSize(firstBlockSize) {}
+
+ParseArena::~ParseArena() {
+    while (m_head != nullptr) {
+        Block* prev = m_head->prev;
+        ::operator delete(m_head);
+        m_head = prev;
+    }
+}
+
+void ParseArena::addBlock(size_t minBytes) {
+    size_t size = std::max(m_nextBlockSize, minBytes + sizeof(Block));
+    Block* block = static_cast<Block*>(::operator new(size));
+    block->prev = m_head;
+    block->size = size;
+    m_head = block;
+    m_cursor = reinterpret_cast<char*>(block + 1);
+    m_end = reinterpret_cast<char*>(block) + size;
+    m_nextBlockSize = std::min<size_t>(m_nextBlockSize * 2, 4 * 1024 * 1024);
+    m_stats.bytesReserved += size;
+    m_stats.blocks++;
+}
+
+void* ParseArena::do_allocate(size_t bytes, size_t alignment) {
+    uintptr_t p = (reinterpret_cast<uintptr_t>(m_cursor) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    if (m_cursor == nullptr || p + bytes > reinterpret_cast<uintptr_t>(m_end)) {
+        addBlock(bytes + alignment);
+        p = (reinterpret_cast<uintptr_t>(m_cursor) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    }
+    m_cursor = reinterpret_cast<char*>(p + bytes);
+    m_stats.allocations++;
+    m_stats.bytesRequested += bytes;
+    return reinterpret_cast<void*>(p);
+}
+
+void ParseArena::release() {
+    if (m_head == nullptr) return;
+    // 只保留最早 (最小) 的一块，其余直接归还
+    while (m_head->prev != nullptr) {
+        Block* prev = m_head->prev;
+        ::operator delete(m_head);
+        m_head = prev;
+    }
+    m_cursor = reinterpret_cast<char*>(m_head + 1);
+    m_end = reinterpret_cast<char*>(m_head) + m_head->size;
+    m_nextBlockSize = m_firstBlockSize * 2;
+    m_stats = ArenaStats();
+    m_stats.bytesReserved = m_head->size;
+    m_stats.blocks = 1;
+}
 
 // =========================================================
 //  Parser 类实现
 // =========================================================
 
 Parser::Parser(Lexer& lexer) 
-    : m_lexer(lexer), m_tempCount(0), m_labelCount(0) 
+    : m_lexer(lexer), m_out(&std::cout), m_err(&std::cerr), m_profileOut(nullptr), m_shiftCount(0), m_reductionCount(0), m_codeBuffer(&m_arena), m_nextQuad(0), m_tempCount(0), m_labelCount(0),
+      m_names(&m_arena), m_nameIndex(&m_arena) 
 {
+}
+
+void Parser::reset() {
+    m_valueStack.clear();
+    m_stateStack.clear();
+    // 先让各容器放弃旧的存储，再整体归还 Arena
+    CodeBuffer(&m_arena).swap(m_codeBuffer);
+    std::pmr::vector<std::string_view>(&m_arena).swap(m_names);
+    std::pmr::unordered_map<std::string_view, int>(&m_arena).swap(m_nameIndex);
+    m_arena.release();
+    m_nextQuad = 0;
+    m_tempCount = 0;
+    m_labelCount = 0;
+    m_shiftCount = 0;
+    m_reductionCount = 0;
+#if PARSER_PROFILE
+    m_profile = ParseProfile();
+#endif
+
     // 初始状态入栈
     m_stateStack.push(0);
-    // 缓冲区自动初始化为空
 }
 
 // ---------------------------------------------------------
@@ -241,86 +1042,517 @@ Parser::Parser(Lexer& lexer)
 // ---------------------------------------------------------
 
 int Parser::nextquad() const {
-    return (int)m_codeBuffer.size();
+    return m_nextQuad;
+}
+
+Operand Parser::newTemp() {
+    return Operand{ OPD_TEMP, ++m_tempCount };
 }
 
-std::string Parser::newTemp() {
-    return "t" + std::to_string(++m_tempCount);
+Operand Parser::newLabel() {
+    return Operand{ OPD_LABEL, ++m_labelCount };
 }
 
-std::string Parser::newLabel() {
-    return "L" + std::to_string(++m_labelCount);
+// 名字驻留：同一名字只在 Arena 中保存一份文本
+Operand Parser::intern(std::string_view name) {
+    auto it = m_nameIndex.find(name);
+    if (it != m_nameIndex.end()) {
+        return Operand{ OPD_NAME, it->second };
+    }
+    char* storage = static_cast<char*>(m_arena.allocate(name.size() + 1, 1));
+    std::copy(name.begin(), name.end(), storage);
+    storage[name.size()] = '\0';
+    std::string_view stored(storage, name.size());
+
+    int index = (int)m_names.size();
+    m_names.push_back(stored);
+    m_nameIndex.emplace(stored, index);
+    return Operand{ OPD_NAME, index };
 }
 
-void Parser::emit(const std::string& code) {
-    m_codeBuffer.push_back(code);
+// 取得第 index 条指令的槽位，不存在则补齐
+// (语义动作常先 makelist(nextquad()) 再 emit，此时槽位尚未生成)
+Quad& Parser::codeSlot(int index) {
+    if ((int)m_codeBuffer.size() <= index) {
+        m_codeBuffer.resize(index + 1);
+    }
+    return m_codeBuffer[index];
 }
 
-std::vector<int> Parser::makelist(int index) {
-    std::vector<int> list;
-    list.push_back(index);
-    return list;
+void Parser::emit(Opcode op, Operand arg1, Operand arg2, Operand result) {
+    Quad& quad = codeSlot(m_nextQuad++);
+    quad.op = op;
+    quad.arg1 = arg1;
+    quad.arg2 = arg2;
+    // 未给出目标时保留槽位上已有的回填链接
+    if (!result.empty()) quad.result = result;
 }
 
-std::vector<int> Parser::merge(const std::vector<int>& list1, const std::vector<int>& list2) {
-    std::vector<int> merged = list1;
-    merged.insert(merged.end(), list2.begin(), list2.end());
-    return merged;
+void Parser::emit(std::string_view text) {
+    emit(OP_TEXT, intern(text));
 }
 
-void Parser::backpatch(const std::vector<int>& list, int targetQuad) {
-    std::string targetStr = std::to_string(targetQuad);
-    for (int index : list) {
-        if (index >= 0 && index < (int)m_codeBuffer.size()) {
-            // 在指令末尾追加目标地址
-            m_codeBuffer[index] += " " + targetStr; 
-        }
+PatchList Parser::makelist(int index) {
+    // 单元素环：链尾指向自己
+    codeSlot(index).result = Operand{ OPD_PENDING, index };
+    return PatchList{ index };
+}
+
+PatchList Parser::merge(PatchList list1, PatchList list2) {
+    if (list1.empty()) return list2;
+    if (list2.empty()) return list1;
+    // 交换两个链尾的后继即可把两个环拼成一个，新的链尾是 list2 的链尾
+    std::swap(m_codeBuffer[list1.tail].result.index, m_codeBuffer[list2.tail].result.index);
+    return list2;
+}
+
+void Parser::backpatch(PatchList list, int targetQuad) {
+    backpatch(list, Operand::quad(targetQuad));
+}
+
+void Parser::backpatch(PatchList list, Operand target) {
+    if (list.empty()) return;
+    // 从链头 (链尾的后继) 出发沿链走一遍
+    int index = m_codeBuffer[list.tail].result.index;
+    while (true) {
+        Quad& quad = m_codeBuffer[index];
+        int next = quad.result.index;
+        quad.result = target;
+        if (index == list.tail) break;
+        index = next;
     }
 }
 
-void Parser::backpatch(const std::vector<int>& list, const std::string& targetLabel) {
-    for (int index : list) {
-        if (index >= 0 && index < (int)m_codeBuffer.size()) {
-            m_codeBuffer[index] += " " + targetLabel;
+std::string Parser::operandText(Operand operand) const {
+    switch (operand.kind) {
+    case OPD_NAME:  return std::string(m_names[operand.index]);
+    case OPD_TEMP:  return "t" + std::to_string(operand.index);
+    case OPD_LABEL: return "L" + std::to_string(operand.index);
+    case OPD_QUAD:  return std::to_string(operand.index);
+    default:        return "";
+    }
+}
+
+void Parser::writeCode(std::ostream& os) const {
+    static const char* const RELOPS[] = { "<", ">", "==" };
+    static const char* const ARITH[] = { "+", "-", "*", "/" };
+
+    for (int i = 0; i < m_nextQuad; ++i) {
+        const Quad& q = m_codeBuffer[i];
+        os << std::setw(3) << i << ": ";
+        switch (q.op) {
+        case OP_ASSIGN:
+            os << operandText(q.result) << " = " << operandText(q.arg1);
+            break;
+        case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV:
+            os << operandText(q.result) << " = " << operandText(q.arg1)
+               << " " << ARITH[q.op - OP_ADD] << " " << operandText(q.arg2);
+            break;
+        case OP_JLT: case OP_JGT: case OP_JEQ:
+            os << "if " << operandText(q.arg1) << " " << RELOPS[q.op - OP_JLT] << " "
+               << operandText(q.arg2) << " goto " << operandText(q.result);
+            break;
+        case OP_GOTO:
+            os << "goto " << operandText(q.result);
+            break;
+        case OP_PRINT:
+            os << "print " << operandText(q.arg1);
+            break;
+        case OP_PARAM:
+            os << "param " << operandText(q.arg1);
+            break;
+        case OP_CALL:
+            os << operandText(q.result) << " = call " << operandText(q.arg1);
+            break;
+        case OP_RET:
+            os << "ret " << operandText(q.arg1);
+            break;
+        case OP_FUNC_BEGIN:
+            os << "begin_func " << operandText(q.arg1) << ", param=" << operandText(q.arg2);
+            break;
+        case OP_FUNC_END:
+            os << "end_func";
+            break;
+        case OP_TEXT:
+            os << operandText(q.arg1);
+            if (!q.result.empty() && q.result.kind != OPD_PENDING) os << " " << operandText(q.result);
+            break;
+        default:
+            os << "nop";
+            break;
         }
+        os << "\n";
     }
 }
 
 void Parser::printGeneratedCode() const {
-    std::cout << "\n=== Intermediate Code Generation ===\n";
-    for (size_t i = 0; i < m_codeBuffer.size(); ++i) {
-        std::cout << std::setw(3) << i << ": " << m_codeBuffer[i] << std::endl;
-    }
-    std::cout << "====================================\n";
+    *m_out << "\n=== Intermediate Code Generation ===\n";
+    writeCode(*m_out);
+    *m_out << "====================================\n";
 }
 
-// ---------------------------------------------------------
+void Parser::setOutputStreams(std::ostream& out, std::ostream& err) {
+    m_out = &out;
+    m_err = &err;
+}
+
+void Parser::setProfileStream(std::ostream* profile) {
+    m_profileOut = profile;
+}
+
+void Parser::printArenaStats(std::ostream& os) const {
+    const ArenaStats& stats = m_arena.stats();
+    os << "[Arena] allocations=" << stats.allocations
+       << " requested=" << stats.bytesRequested << "B"
+       << " reserved=" << stats.bytesReserved << "B"
+       << " blocks=" << stats.blocks << std::endl;
+}
+
+)"
+// (MSVC 单个字符串字面量长度有限，模板分段拼接)
+R"(// ---------------------------------------------------------
 //  核心解析逻辑
 // ---------------------------------------------------------
 
 void Parser::reportError(const Token& token) {
-    std::cerr << "[Syntax Error] Unexpected token '" << token.type 
+    *m_err << "[Syntax Error] Unexpected token '" << token.type 
               << "' (" << token.text << ") at line " << token.line << std::endl;
 }
 
-int Parser::getGoto(int state, const std::string& lhs) {
-{{GOTO_TABLE_LOGIC}}
-    return -1; 
+int Parser::getGoto(int state, int nonterminal) {
+    int index = PARSER_GOTO_BASE[nonterminal] + state;
+    if (index >= 0 && index < PARSER_GOTO_TABLE_SIZE && PARSER_GOTO_CHECK[index] == state) {
+        return PARSER_GOTO_NEXT[index];
+    }
+    return PARSER_GOTO_DEFAULT[nonterminal];
+}
+
+// 终结符名 -> 编号 (二分查找)，未知的 Token 类型 (如 ERROR) 返回 -1
+static int terminalId(const std::string& type) {
+    const char* const* first = PARSER_TERMINAL_NAMES;
+    const char* const* last = PARSER_TERMINAL_NAMES + PARSER_TERMINAL_COUNT;
+    const char* const* it = std::lower_bound(first, last, type,
+        [](const char* name, const std::string& key) { return key.compare(name) > 0; });
+    if (it != last && type == *it) return (int)(it - first);
+    return -1;
 }
 
 bool Parser::parse() {
-    Token lookahead = m_lexer.nextToken();
+    // 每次解析都从干净的状态开始，上一次解析占用的 Arena 在这里整块释放
+    reset();
+#if PARSER_PIPELINE
+    startLexerThread();
+    bool accepted = parseLoop();
+    stopLexerThread();
+#else
+    bool accepted = parseLoop();
+#endif
+    // 解析结束后语义值不再需要；代码缓冲区保留到下一次 parse()
+    m_valueStack.clear();
+    m_stateStack.clear();
+#if PARSER_PROFILE
+    if (m_profileOut != nullptr) {
+        dumpProfile(*m_profileOut);
+    }
+    else {
+        std::ofstream profileFile(PARSER_PROFILE_PATH);
+        if (profileFile.is_open()) dumpProfile(profileFile);
+    }
+#endif
+    return accepted;
+}
+
+#if PARSER_PROFILE
+void Parser::dumpProfile(std::ostream& os) const {
+    os << "{\n";
+    os << "  \"shifts\": " << m_profile.shifts << ",\n";
+    os << "  \"reductions\": " << m_profile.reductions << ",\n";
+    os << "  \"maxStackDepth\": " << m_profile.maxStackDepth << ",\n";
+
+    // 只列出计数非零的规则与状态
+    os << "  \"rules\": [";
+    bool first = true;
+    for (int i = 0; i < PARSER_RULE_COUNT; ++i) {
+        if (m_profile.ruleReduces[i] == 0) continue;
+        os << (first ? "\n" : ",\n") << "    {\"id\": " << i << ", \"rule\": \"" << PARSER_RULE_NAMES[i]
+           << "\", \"count\": " << m_profile.ruleReduces[i] << "}";
+        first = false;
+    }
+    os << "\n  ],\n";
+
+    os << "  \"states\": [";
+    first = true;
+    for (int i = 0; i < PARSER_STATE_COUNT; ++i) {
+        if (m_profile.stateVisits[i] == 0) continue;
+        os << (first ? "\n" : ",\n") << "    {\"state\": " << i << ", \"visits\": " << m_profile.stateVisits[i] << "}";
+        first = false;
+    }
+    os << "\n  ]\n";
+    os << "}\n";
+}
+#endif
+
+#if PARSER_PIPELINE
+void Parser::startLexerThread() {
+    m_stopLexer.store(false, std::memory_order_relaxed);
+    m_lexerThread = std::thread([this]() {
+        while (true) {
+            Token token = m_lexer.nextToken();
+            bool isEnd = token.type == "#";
+            // 队列满时让出 CPU；Parser 提前结束 (出错) 时放弃剩余输入
+            while (!m_tokenRing.tryPush(std::move(token))) {
+                if (m_stopLexer.load(std::memory_order_relaxed)) return;
+                std::this_thread::yield();
+            }
+            if (isEnd) return;
+        }
+    });
+}
+
+void Parser::stopLexerThread() {
+    m_stopLexer.store(true, std::memory_order_relaxed);
+    if (m_lexerThread.joinable()) m_lexerThread.join();
+    m_tokenRing.clear();
+    m_batchPos = 0;
+    m_batchCount = 0;
+}
+#endif
+
+// 取下一个 Token：流水线模式下从本地批量缓冲中取，用完再从队列批量补充
+Token Parser::nextToken() {
+#if PARSER_PIPELINE
+    if (m_batchPos == m_batchCount) {
+        while ((m_batchCount = m_tokenRing.tryPopBatch(m_tokenBatch, PARSER_TOKEN_BATCH)) == 0) {
+            std::this_thread::yield();
+        }
+        m_batchPos = 0;
+    }
+    return std::move(m_tokenBatch[m_batchPos++]);
+#else
+    return m_lexer.nextToken();
+#endif
+}
+
+// ---------------------------------------------------------
+//  解析内核：查 ACTION 表，移进或归约；语义动作经 REDUCE_TABLE (按规则编号索引的成员函数指针表) 分派，无动作的规则为 nullptr
+// ---------------------------------------------------------
+bool Parser::parseLoop() {
+    Token lookahead = nextToken();
+    int terminal = terminalId(lookahead.type);
 
     while (true) {
         int state = m_stateStack.top();
-        std::string type = lookahead.type;
+        PARSER_PROFILE_VISIT(state);
 
-        // ============================================================
-        //  ACTION 表逻辑
-        // ============================================================
-        
-{{ACTION_TABLE_LOGIC}}
-       
+        int action = terminal < 0 ? 0 : PARSER_ACTION[state * PARSER_TERMINAL_COUNT + terminal];
+
+        if (action > 0) {
+            // 移进
+            PARSER_TRACE_LOG(2, "[Shift] " << lookahead.type << " -> state " << action - 1);
+            PARSER_PROFILE_SHIFT();
+            m_shiftCount++;
+            m_stateStack.push(action - 1);
+            m_valueStack.push(TokenValue(lookahead.text, lookahead.line, &m_arena));
+            lookahead = nextToken();
+            terminal = terminalId(lookahead.type);
+        }
+        else if (action < 0) {
+            int rule = -action - 1;
+            if (rule == 0) {
+                // 接受
+                printGeneratedCode();
+                return true;
+            }
+
+            // 归约
+            PARSER_TRACE_LOG(1, "[Reduce] " << PARSER_RULE_NAMES[rule]);
+            PARSER_PROFILE_REDUCE(rule);
+            m_reductionCount++;
+
+            // 右部的值直接在栈上原地访问，结果写入左部所在的槽位 (右部第一个符号的位置)
+            int length = PARSER_RULE_LENGTH[rule];
+            if (length == 0) {
+                m_valueStack.push(StackValue());
+            }
+            ReduceFn reduceFn = REDUCE_TABLE[rule];
+            if (reduceFn != nullptr) {
+                StackValue* rhs = m_valueStack.slots(length == 0 ? 1 : length);
+                (this->*reduceFn)(rhs, rhs[0]);
+            }
+
+            // 弹出右部 (栈指针只移动一次)，再查 GOTO 表压入新状态
+            if (length > 0) {
+                m_stateStack.popN(length);
+                m_valueStack.popN(length - 1);
+            }
+            m_stateStack.push(getGoto(m_stateStack.top(), PARSER_RULE_LHS[rule]));
+        }
+        else {
+            // 出错
+            reportError(lookahead);
+            return false;
+        }
     }
 }
-)";
\ No newline at end of file
+{{TABLE_DATA}}{{ACTION_FUNCTIONS}})";
+
+// =========================================================
+// 4.1 Parser 表数据模版 (parser_tables.cpp，分片模式)
+// =========================================================
+const std::string TEMPLATE_PARSER_TABLES_CPP = R"(
+#include "parser.h"
+{{TABLE_DATA}})";
+
+// =========================================================
+// 4.2 Parser 语义动作模版 (parser_actions_N.cpp，分片模式)
+// =========================================================
+const std::string TEMPLATE_PARSER_ACTIONS_CPP = R"(
+#include "parser.h"
+
+// 语义动作分片 {{SHARD_INDEX}} / {{SHARD_COUNT}}
+{{ACTION_FUNCTIONS}})";
+// =========================================================
+// 5. 批处理驱动模版 (batch_main.cpp)
+// =========================================================
+const std::string TEMPLATE_BATCH_MAIN_CPP = R"(
+// 批处理驱动：把一批源文件分给线程池编译，按输入顺序输出结果
+// 用法: batch <文件列表> [线程数]
+//   文件列表每行一个源文件路径
+//
+// 每个工作线程持有自己的 Lexer/Parser (以及 Parser 内的 Arena)，
+// 生成的类不含可变全局状态，分析表是只读代码，因此无需加锁
+// 以 -DPARSER_PROFILE=1 编译时，各文件的剖析数据分别收集，最后按输入顺序写成
+// PARSER_PROFILE_PATH 中的一个 JSON 数组 [{"file": ..., "profile": {...}}, ...]
+#include "lexer.h"
+#include "parser.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <string>
+
+struct BatchResult {
+    std::string output; // 该文件的生成代码与错误信息
+    std::string profile; // 该文件的剖析数据 (PARSER_PROFILE=1)
+    bool accepted = false;
+    bool done = false;
+};
+
+static bool readFile(const std::string& path, std::string& content) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    content = buffer.str();
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <file-list> [threads]" << std::endl;
+        return 2;
+    }
+
+    std::vector<std::string> files;
+    {
+        std::ifstream list(argv[1]);
+        if (!list.is_open()) {
+            std::cerr << "Error: Could not open file list " << argv[1] << std::endl;
+            return 2;
+        }
+        std::string line;
+        while (std::getline(list, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty()) files.push_back(line);
+        }
+    }
+
+    unsigned threadCount = argc >= 3 ? (unsigned)std::stoul(argv[2]) : std::thread::hardware_concurrency();
+    if (threadCount == 0) threadCount = 1;
+    if (threadCount > files.size()) threadCount = files.empty() ? 1 : (unsigned)files.size();
+
+    std::vector<BatchResult> results(files.size());
+    std::atomic<size_t> nextFile(0);
+    std::mutex resultMutex;
+    std::condition_variable resultReady;
+
+    auto worker = [&]() {
+        Lexer lexer("");
+        Parser parser(lexer);
+        std::string source;
+        std::ostringstream out;
+        std::ostringstream profile;
+        parser.setOutputStreams(out, out);
+        parser.setProfileStream(&profile);
+
+        // 动态领取文件，避免大小不均的文件拖慢某个线程
+        for (size_t i = nextFile++; i < files.size(); i = nextFile++) {
+            out.str("");
+            out.clear();
+            profile.str("");
+            profile.clear();
+            bool accepted = false;
+            if (readFile(files[i], source)) {
+                lexer.reset(source);
+                accepted = parser.parse();
+            }
+            else {
+                out << "[Error] Could not open " << files[i] << "\n";
+            }
+
+            std::lock_guard<std::mutex> lock(resultMutex);
+            results[i].output = out.str();
+            results[i].profile = profile.str();
+            results[i].accepted = accepted;
+            results[i].done = true;
+            resultReady.notify_one();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threadCount; ++t) pool.emplace_back(worker);
+
+    // 主线程按输入顺序输出，已写出的结果立即释放
+#if PARSER_PROFILE
+    std::ofstream profileFile(PARSER_PROFILE_PATH);
+    profileFile << "[";
+#endif
+    size_t failed = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        std::string output;
+        std::string profile;
+        bool accepted;
+        {
+            std::unique_lock<std::mutex> lock(resultMutex);
+            resultReady.wait(lock, [&]() { return results[i].done; });
+            output.swap(results[i].output);
+            profile.swap(results[i].profile);
+            accepted = results[i].accepted;
+        }
+        std::cout << "### " << files[i] << (accepted ? "" : " [FAILED]") << "\n" << output;
+        if (!accepted) failed++;
+#if PARSER_PROFILE
+        std::string name;
+        for (char c : files[i]) {
+            if (c == '"' || c == '\\') name += '\\';
+            name += c;
+        }
+        profileFile << (i == 0 ? "\n" : ",\n") << "{\"file\": \"" << name << "\", \"profile\": "
+                    << (profile.empty() ? "null\n" : profile) << "}";
+#endif
+    }
+#if PARSER_PROFILE
+    profileFile << "\n]\n";
+#endif
+
+    for (auto& thread : pool) thread.join();
+
+    std::cout.flush();
+    std::cerr << "[Batch] " << files.size() << " files, " << failed << " failed, "
+              << threadCount << " threads" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
+)";
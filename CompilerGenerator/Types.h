@@ -22,18 +22,62 @@ struct ProductionRule {
     std::string semanticAction;    // 语义动作代码，例如 "{ $$ = $1 + $3; }"
 };
 
+// 非终结符的语义值类型声明 (规则文件中的 %type <字段...> 符号...)
+// Key: 非终结符名 -> 该符号需要的 SemanticValue 字段列表
+// 未声明的非终结符仍使用完整的 SemanticValue
+using SymbolTypeMap = std::map<std::string, std::vector<std::string>>;
+
 // === 词法分析器产出 ===
 
+// 字符区间上的转移：输入字节在 [low, high] 内 (按 unsigned char 取值) 时跳转到 target
+// 字符类按区间存放，[^"] 这样的大字符类在各阶段的代价只与区间数有关，与字符数无关
+struct CharRange {
+    unsigned char low;
+    unsigned char high;
+    int target;
+};
+
 // DFA 转换表的一行
 struct DFARow {
     int stateID;
     bool isFinal;
     std::string tokenName; //如果是终态，对应的Token名字
-    std::map<char, int> transitions; // 输入 char -> 跳转到 stateID
+    std::vector<CharRange> transitions; // 按 low 升序，区间互不重叠，相邻且目标相同的区间已合并
 };
 
+// 在按 low 升序、互不重叠的区间转移中查找字符 c 的目标，没有转移返回 -1
+inline int findTransition(const std::vector<CharRange>& transitions, unsigned char c) {
+    size_t lo = 0, hi = transitions.size();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (transitions[mid].high < c) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < transitions.size() && transitions[lo].low <= c ? transitions[lo].target : -1;
+}
+
 using DFATable = std::vector<DFARow>;
 
+// 关键字 (从 DFA 中移出的字面串规则)
+// 字面串完全被后面的某条标识符规则覆盖时，DFA 只识别标识符，
+// 生成的词法分析器再用完美哈希把等于关键字的词素改判为关键字 Token
+struct KeywordDefinition {
+    std::string name;      // 例如 "WHILE"
+    std::string text;      // 例如 "while"
+    std::string coverName; // 覆盖它的规则，例如 "ID"
+};
+
+// 紧凑 NFA (惰性 DFA 模式)
+// 子集构造超出状态上限时，生成的词法分析器嵌入这份 NFA，运行时按需构造 DFA 状态
+// 状态编号连续 (0 ~ size-1)；accept 为终态对应规则在 tokenNames 中的下标 (越小优先级越高)，非终态为 -1
+struct CompactNFA {
+    int startState;
+    std::vector<std::string> tokenNames;               // 按规则定义顺序
+    std::vector<int> accept;                           // 每个状态
+    std::vector<std::vector<int>> epsilon;             // 每个状态的 epsilon 转移
+    std::vector<std::vector<CharRange>> transitions;   // 每个状态的字符区间转移
+};
+
 // === 语法分析器产出 ===
 
 // LR 分析动作类型
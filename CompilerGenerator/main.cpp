@@ -3,31 +3,153 @@
 #include "LexerGenerator.h"
 #include "ParserGenerator.h"
 #include "CodeEmitter.h"
+#include "GeneratorStats.h"
+#include "SentenceGenerator.h"
 #include <iostream>
+#include <cstdlib>
+
+// "64K" / "100M" / "2G" -> 字节数
+static unsigned long long parseSize(const std::string& text)
+{
+    char *end = nullptr;
+    unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+    switch (end != nullptr ? *end : '\0')
+    {
+    case 'K': case 'k': return value << 10;
+    case 'M': case 'm': return value << 20;
+    case 'G': case 'g': return value << 30;
+    default: return value;
+    }
+}
 
 int main(int argc, char *argv[])
 {
     // 默认读取 rules.txt
+    // 用法: CompilerGenerator [规则文件] [--batch] [--pipeline] [--shards N]
+    //   --batch     额外生成多线程批处理驱动 batch_main.cpp
+    //   --pipeline  生成的 Parser 默认在独立线程中进行词法分析
+    //   --shards N  把 Parser 拆分为表数据与 N 个语义动作编译单元，便于并行编译
+    //   --stats     统计各阶段耗时、内存分配与规模，写入 generator_stats.json
+    //   --trace F   同时把阶段时间线以 Chrome trace-event 格式写入 F (隐含 --stats)
+    //   --sentences SIZE F  按文法随机生成约 SIZE 字节 (可带 K/M/G) 的合法程序写入 F，用作压测输入
+    //   --seed N / --max-depth D  随机程序的种子与推导深度上限
+    //   --dfa-budget N  子集构造的 DFA 状态上限 (默认 10000，0 不限制)，超出时生成惰性 DFA 词法分析器
+    //   --lazy-dfa      总是生成惰性 DFA 词法分析器
+    //   --keyword-dfa   关键字保留在 DFA 中 (默认移出 DFA，用完美哈希识别)
+    //   --lexer-construction thompson|followpos|derivatives  DFA 构造方法 (默认 thompson)
+    //   --lexer-threads N  Thompson NFA 与子集构造的线程数 (默认 1，0 为硬件线程数)，输出与单线程相同
     std::string filename = "rules.txt";
-    if (argc >= 2)
+    bool emitBatch = false;
+    bool collectStats = false;
+    std::string tracePath;
+    std::string sentencePath;
+    SentenceOptions sentenceOptions;
+    EmitterOptions emitOptions;
+    size_t dfaBudget = LexerGenerator::DEFAULT_DFA_STATE_BUDGET;
+    bool forceLazyDFA = false;
+    bool keywordHashing = true;
+    LexerConstruction construction = LEXER_THOMPSON;
+    unsigned int lexerThreads = 1;
+    for (int i = 1; i < argc; ++i)
     {
-        filename = argv[1];
+        std::string arg = argv[i];
+        if (arg == "--batch")
+        {
+            emitBatch = true;
+        }
+        else if (arg == "--pipeline")
+        {
+            emitOptions.pipeline = true;
+        }
+        else if (arg == "--shards" && i + 1 < argc)
+        {
+            emitOptions.shards = std::atoi(argv[++i]);
+        }
+        else if (arg == "--stats")
+        {
+            collectStats = true;
+        }
+        else if (arg == "--trace" && i + 1 < argc)
+        {
+            collectStats = true;
+            tracePath = argv[++i];
+        }
+        else if (arg == "--sentences" && i + 2 < argc)
+        {
+            sentenceOptions.targetBytes = parseSize(argv[++i]);
+            sentencePath = argv[++i];
+        }
+        else if (arg == "--seed" && i + 1 < argc)
+        {
+            sentenceOptions.seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--max-depth" && i + 1 < argc)
+        {
+            sentenceOptions.maxDepth = std::atoi(argv[++i]);
+        }
+        else if (arg == "--dfa-budget" && i + 1 < argc)
+        {
+            dfaBudget = (size_t)std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--lazy-dfa")
+        {
+            forceLazyDFA = true;
+        }
+        else if (arg == "--keyword-dfa")
+        {
+            keywordHashing = false;
+        }
+        else if (arg == "--lexer-construction" && i + 1 < argc)
+        {
+            std::string name = argv[++i];
+            if (name == "thompson")
+                construction = LEXER_THOMPSON;
+            else if (name == "followpos")
+                construction = LEXER_FOLLOWPOS;
+            else if (name == "derivatives")
+                construction = LEXER_DERIVATIVES;
+            else
+                std::cerr << "[Warning] Unknown lexer construction " << name << " ignored." << std::endl;
+        }
+        else if (arg == "--lexer-threads" && i + 1 < argc)
+        {
+            lexerThreads = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg.compare(0, 2, "--") == 0)
+        {
+            std::cerr << "[Warning] Unknown option " << arg << " ignored." << std::endl;
+        }
+        else
+        {
+            filename = arg;
+        }
     }
 
     std::cout << "============================================" << std::endl;
     std::cout << "   Compiler Generator (The C++ Team)" << std::endl;
     std::cout << "============================================" << std::endl;
 
+    GeneratorStats statsData;
+    GeneratorStats *stats = collectStats ? &statsData : nullptr;
+    GeneratorStats::setAllocationCounting(collectStats);
+
     // ---------------------------------------------------------
     // 阶段 1: 读取与解析 (前端)
     // ---------------------------------------------------------
     std::cout << "[Step 1] Parsing rule file: " << filename << "..." << std::endl;
 
     CodeEmitter emitter("output");
+    emitter.setOptions(emitOptions);
     std::vector<TokenDefinition> tokenDefs;
     std::vector<ProductionRule> grammarRules;
+    SymbolTypeMap symbolTypes;
 
-    if (!emitter.parseInputFile(filename, tokenDefs, grammarRules))
+    bool parsed;
+    {
+        StatsPhase phase(stats, "input");
+        parsed = emitter.parseInputFile(filename, tokenDefs, grammarRules, symbolTypes);
+    }
+    if (!parsed)
     {
         std::cerr << "[Error] Failed to parse input file. Aborting." << std::endl;
         return 1;
@@ -35,6 +157,7 @@ int main(int argc, char *argv[])
 
     std::cout << "   -> Found " << tokenDefs.size() << " lexical rules." << std::endl;
     std::cout << "   -> Found " << grammarRules.size() << " grammar rules." << std::endl;
+    std::cout << "   -> Found " << symbolTypes.size() << " typed symbols (%type)." << std::endl;
 
     if (tokenDefs.empty() || grammarRules.empty())
     {
@@ -47,6 +170,12 @@ int main(int argc, char *argv[])
     std::cout << "[Step 2] Building Lexer (DFA Construction)..." << std::endl;
 
     LexerGenerator lexGen;
+    lexGen.setStats(stats);
+    lexGen.setDFAStateBudget(dfaBudget);
+    lexGen.setForceLazyDFA(forceLazyDFA);
+    lexGen.setKeywordHashing(keywordHashing);
+    lexGen.setConstruction(construction);
+    lexGen.setThreads(lexerThreads);
 
     // 将解析出的 Token 规则喂给 LexerGenerator
     for (const auto &token : tokenDefs)
@@ -55,8 +184,19 @@ int main(int argc, char *argv[])
     }
 
     // 执行核心算法 (Regex -> NFA -> DFA)
-    lexGen.build();
+    {
+        StatsPhase phase(stats, "lexer.build");
+        lexGen.build();
+    }
 
+    if (!lexGen.getKeywords().empty())
+    {
+        std::cout << "   -> " << lexGen.getKeywords().size() << " keyword(s) recognized by perfect hash instead of the DFA." << std::endl;
+    }
+    if (lexGen.isLazyDFA())
+    {
+        std::cout << "   -> DFA state budget exceeded (or --lazy-dfa), using lazy DFA lexer." << std::endl;
+    }
     std::cout << "   -> Lexer build complete." << std::endl;
 
     // ---------------------------------------------------------
@@ -65,6 +205,7 @@ int main(int argc, char *argv[])
     std::cout << "[Step 3] Building Parser (LR Table Construction)..." << std::endl;
 
     ParserGenerator parserGen;
+    parserGen.setStats(stats);
 
     // 默认将第一条语法规则的左部设为起始符号 (Start Symbol)
     if (!grammarRules.empty())
@@ -79,7 +220,10 @@ int main(int argc, char *argv[])
     }
 
     // 执行核心算法 (First/Follow -> Items -> LR Table)
-    parserGen.build();
+    {
+        StatsPhase phase(stats, "parser.build");
+        parserGen.build();
+    }
 
     std::cout << "   -> Parser build complete." << std::endl;
 
@@ -89,25 +233,88 @@ int main(int argc, char *argv[])
     std::cout << "[Step 4] Emitting Target C++ Code..." << std::endl;
 
     // 生成 lex.cpp
-    if (!emitter.emitLexer(lexGen.getDFATable()))
+    bool emitted;
+    {
+        StatsPhase phase(stats, "emit.lexer");
+        emitted = lexGen.isLazyDFA() ? emitter.emitLazyLexer(lexGen.getCompactNFA(), lexGen.getKeywords())
+                                     : emitter.emitLexer(lexGen.getDFATable(), lexGen.getKeywords());
+    }
+    if (!emitted)
     {
         std::cerr << "[Error] Failed to generate lexer code." << std::endl;
         return 1;
     }
 
     // 生成 parser.cpp
-    if (!emitter.emitParser(
+    {
+        StatsPhase phase(stats, "emit.parser");
+        emitted = emitter.emitParser(
             parserGen.getActionTable(),
             parserGen.getGotoTable(),
-            parserGen.getRules()))
+            parserGen.getRules(),
+            symbolTypes);
+    }
+    if (!emitted)
     {
         std::cerr << "[Error] Failed to generate parser code." << std::endl;
         return 1;
     }
 
+    // 生成 batch_main.cpp (可选)
+    if (emitBatch && !emitter.emitBatchDriver())
+    {
+        std::cerr << "[Error] Failed to generate batch driver." << std::endl;
+        return 1;
+    }
+
+    // 随机程序 (可选)
+    if (!sentencePath.empty())
+    {
+        std::cout << "[Step 5] Generating random program: " << sentencePath << "..." << std::endl;
+        StatsPhase phase(stats, "sentences");
+        if (lexGen.isLazyDFA())
+        {
+            std::cerr << "[Error] --sentences samples token text from the DFA; it is not available with the lazy DFA lexer." << std::endl;
+            return 1;
+        }
+        SentenceGenerator sentenceGen(parserGen.getRules(), lexGen.getDFATable(),
+                                      parserGen.getActionTable(), parserGen.getGotoTable());
+        sentenceGen.setOptions(sentenceOptions);
+        sentenceGen.setKeywords(lexGen.getKeywords());
+        if (!sentenceGen.prepare() || !sentenceGen.generateFile(sentencePath))
+        {
+            std::cerr << "[Error] Failed to generate random program." << std::endl;
+            return 1;
+        }
+    }
+
     std::cout << "============================================" << std::endl;
     std::cout << "   Success! Files generated!" << std::endl;
     std::cout << "============================================" << std::endl;
 
+    // ---------------------------------------------------------
+    // 统计报告 (--stats / --trace)
+    // ---------------------------------------------------------
+    if (stats != nullptr)
+    {
+        stats->setCounter("emittedBytes", (long long)emitter.getEmittedBytes());
+        stats->printSummary(std::cout);
+
+        if (!stats->writeJson("generator_stats.json", filename))
+        {
+            return 1;
+        }
+        std::cout << "   -> Statistics written to generator_stats.json" << std::endl;
+
+        if (!tracePath.empty())
+        {
+            if (!stats->writeChromeTrace(tracePath))
+            {
+                return 1;
+            }
+            std::cout << "   -> Trace written to " << tracePath << std::endl;
+        }
+    }
+
     return 0;
 }
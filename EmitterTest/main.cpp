@@ -11,16 +11,17 @@
 // 1. 辅助工具
 // ==========================================
 
+// 转移按 low 升序存放 (见 DFARow)，插入到对应位置
 static void addRange(DFARow& row, char start, char end, int targetState) {
-    for (char c = start; c <= end; ++c) {
-        row.transitions[c] = targetState;
-    }
+    auto it = row.transitions.begin();
+    while (it != row.transitions.end() && it->low < (unsigned char)start) ++it;
+    row.transitions.insert(it, CharRange{ (unsigned char)start, (unsigned char)end, targetState });
 }
 
 // ==========================================
 // 2. 构建 DFA (词法分析器数据)
 // ==========================================
-// 新增: ';' (SEMI)
+// 新增: ';' (SEMI)、'%' (MOD)
 DFATable createMockDFA() {
     DFATable dfa;
 
@@ -29,15 +30,16 @@ DFATable createMockDFA() {
         DFARow r; r.stateID = 0; r.isFinal = false;
         addRange(r, '0', '9', 1); // NUM
         addRange(r, 'a', 'z', 2); // ID
-        r.transitions['+'] = 3;   // PLUS
-        r.transitions['*'] = 4;   // MUL
-        r.transitions['='] = 5;   // ASSIGN
-        r.transitions['('] = 6;   // LPAREN
-        r.transitions[')'] = 7;   // RPAREN
-        r.transitions['?'] = 8;   // IF
-        r.transitions['<'] = 9;   // RELOP
-        r.transitions[';'] = 10;  // SEMI (新增)
-        r.transitions[' '] = 0;   // Skip
+        addRange(r, '%', '%', 11); // MOD
+        addRange(r, '+', '+', 3); // PLUS
+        addRange(r, '*', '*', 4); // MUL
+        addRange(r, '=', '=', 5); // ASSIGN
+        addRange(r, '(', '(', 6); // LPAREN
+        addRange(r, ')', ')', 7); // RPAREN
+        addRange(r, '?', '?', 8); // IF
+        addRange(r, '<', '<', 9); // RELOP
+        addRange(r, ';', ';', 10); // SEMI (新增)
+        addRange(r, ' ', ' ', 0); // Skip
         dfa.push_back(r);
     }
 
@@ -53,6 +55,8 @@ DFATable createMockDFA() {
     { DFARow r; r.stateID = 9; r.isFinal = true; r.tokenName = "RELOP"; dfa.push_back(r); }
     // 新增: 分号
     { DFARow r; r.stateID = 10; r.isFinal = true; r.tokenName = "SEMI"; dfa.push_back(r); }
+    // 新增: 取模
+    { DFARow r; r.stateID = 11; r.isFinal = true; r.tokenName = "MOD"; dfa.push_back(r); }
 
     return dfa;
 }
@@ -65,19 +69,18 @@ std::vector<ProductionRule> createMockRules() {
 
     // Rule 0: S' -> L (Augmented start symbol, L 代表 List)
     rules.push_back({ 0, "S'", {"L"},
-        "backpatch($1.nextList, nextquad());\n"
-        "            emit(\"// End of Program\");" // 可选：生成一个显式的结束标记
+        "backpatch($1.nextList, nextquad());"
         });
 
     // Rule 1: S -> ID ASSIGN E
     rules.push_back({ 1, "S", {"ID", "ASSIGN", "E"},
-        "emit($1.text + \" = \" + $3.var);"
+        "emit(OP_ASSIGN, $3.var, {}, intern($1.text));"
         });
 
     // Rule 2: E -> E PLUS T
     rules.push_back({ 2, "E", {"E", "PLUS", "T"},
         "$$.var = newTemp();\n"
-        "            emit($$.var + \" = \" + $1.var + \" + \" + $3.var);"
+        "            emit(OP_ADD, $1.var, $3.var, $$.var);"
         });
 
     // Rule 3: E -> T
@@ -86,7 +89,7 @@ std::vector<ProductionRule> createMockRules() {
     // Rule 4: T -> T MUL F
     rules.push_back({ 4, "T", {"T", "MUL", "F"},
         "$$.var = newTemp();\n"
-        "            emit($$.var + \" = \" + $1.var + \" * \" + $3.var);"
+        "            emit(OP_MUL, $1.var, $3.var, $$.var);"
         });
 
     // Rule 5: T -> F
@@ -96,17 +99,17 @@ std::vector<ProductionRule> createMockRules() {
     rules.push_back({ 6, "F", {"LPAREN", "E", "RPAREN"}, "$$.var = $2.var;" });
 
     // Rule 7: F -> NUM
-    rules.push_back({ 7, "F", {"NUM"}, "$$.var = $1.text;" });
+    rules.push_back({ 7, "F", {"NUM"}, "$$.var = intern($1.text);" });
 
     // Rule 8: F -> ID
-    rules.push_back({ 8, "F", {"ID"}, "$$.var = $1.text;" });
+    rules.push_back({ 8, "F", {"ID"}, "$$.var = intern($1.text);" });
 
     // Rule 9: B -> E RELOP E
     rules.push_back({ 9, "B", {"E", "RELOP", "E"},
         "$$.trueList = makelist(nextquad());\n"
         "            $$.falseList = makelist(nextquad() + 1);\n"
-        "            emit(\"if \" + $1.var + \" < \" + $3.var + \" goto\");\n"
-        "            emit(\"goto\");"
+        "            emit(OP_JLT, $1.var, $3.var);\n"
+        "            emit(OP_GOTO);"
         });
 
     // Rule 10: M -> epsilon
@@ -133,6 +136,15 @@ std::vector<ProductionRule> createMockRules() {
         "            $$.nextList = $4.nextList;"
         });
 
+    // --- 新增：内置操作码之外的指令 ---
+
+    // Rule 14: T -> T MOD F
+    // 没有 OP_MOD，用文本指令 emit(std::string_view) 生成
+    rules.push_back({ 14, "T", {"T", "MOD", "F"},
+        "$$.var = newTemp();\n"
+        "            emit(operandText($$.var) + \" = \" + operandText($1.var) + \" % \" + operandText($3.var));"
+        });
+
     return rules;
 }
 
@@ -140,6 +152,7 @@ std::vector<ProductionRule> createMockRules() {
 // 4. 构建 LR 分析表
 // ==========================================
 void createMockParserTables(ActionTable& actionTbl, GotoTable& gotoTbl) {
+    // 输入结束符 (EOF) 与生成的词法分析器一致，记为 "#"
     // === 基础层级 (State 0-24) ===
     // 我们保留大部分之前的逻辑，但在 State 0 和 State 1 做关键修改以支持 L
 
@@ -155,12 +168,12 @@ void createMockParserTables(ActionTable& actionTbl, GotoTable& gotoTbl) {
     gotoTbl[{0, "S'"}] = 30;
 
     // State 1: Accepted L. Expect EOF or SEMI (L -> L . ; M S)
-    actionTbl[{1, "EOF"}] = { ACTION_REDUCE, 0 };
+    actionTbl[{1, "#"}] = { ACTION_REDUCE, 0 };
     actionTbl[{1, "SEMI"}] = { ACTION_SHIFT, 26 };
 
     // State 25: Seen "S". Reduce L -> S (Rule 12)
     // S 后面可能跟着 EOF 或者 SEMI
-    actionTbl[{25, "EOF"}] = { ACTION_REDUCE, 12 };
+    actionTbl[{25, "#"}] = { ACTION_REDUCE, 12 };
     actionTbl[{25, "SEMI"}] = { ACTION_REDUCE, 12 };
 
     // --- 状态 2-24 保持原样 (省略重复代码，直接复制之前的逻辑) ---
@@ -171,22 +184,24 @@ void createMockParserTables(ActionTable& actionTbl, GotoTable& gotoTbl) {
 
     // State 4
     actionTbl[{4, "PLUS"}] = { ACTION_SHIFT, 9 };
-    actionTbl[{4, "EOF"}] = { ACTION_REDUCE, 1 };
+    actionTbl[{4, "#"}] = { ACTION_REDUCE, 1 };
     actionTbl[{4, "SEMI"}] = { ACTION_REDUCE, 1 }; // S 结束可能是分号
 
     // State 5
     actionTbl[{5, "MUL"}] = { ACTION_SHIFT, 10 };
-    actionTbl[{5, "PLUS"}] = { ACTION_REDUCE, 3 }; actionTbl[{5, "EOF"}] = { ACTION_REDUCE, 3 }; actionTbl[{5, "RELOP"}] = { ACTION_REDUCE, 3 }; actionTbl[{5, "RPAREN"}] = { ACTION_REDUCE, 3 };
+    actionTbl[{5, "PLUS"}] = { ACTION_REDUCE, 3 }; actionTbl[{5, "#"}] = { ACTION_REDUCE, 3 }; actionTbl[{5, "RELOP"}] = { ACTION_REDUCE, 3 }; actionTbl[{5, "RPAREN"}] = { ACTION_REDUCE, 3 };
     actionTbl[{5, "SEMI"}] = { ACTION_REDUCE, 3 }; // 增加 SEMI 规约
+    actionTbl[{5, "MOD"}] = { ACTION_SHIFT, 31 };
 
     // State 6, 7, 8 (规约状态增加 SEMI)
     auto addReduce = [&](int state, int rule) {
         actionTbl[{state, "MUL"}] = { ACTION_REDUCE, rule };
         actionTbl[{state, "PLUS"}] = { ACTION_REDUCE, rule };
-        actionTbl[{state, "EOF"}] = { ACTION_REDUCE, rule };
+        actionTbl[{state, "#"}] = { ACTION_REDUCE, rule };
         actionTbl[{state, "RELOP"}] = { ACTION_REDUCE, rule };
         actionTbl[{state, "RPAREN"}] = { ACTION_REDUCE, rule };
         actionTbl[{state, "SEMI"}] = { ACTION_REDUCE, rule }; // 新增
+        actionTbl[{state, "MOD"}] = { ACTION_REDUCE, rule };
         };
     addReduce(6, 5); addReduce(7, 7); addReduce(8, 8);
 
@@ -205,8 +220,9 @@ void createMockParserTables(ActionTable& actionTbl, GotoTable& gotoTbl) {
     addReduce(13, 6);
     // State 14
     actionTbl[{14, "MUL"}] = { ACTION_SHIFT, 10 };
-    actionTbl[{14, "PLUS"}] = { ACTION_REDUCE, 2 }; actionTbl[{14, "EOF"}] = { ACTION_REDUCE, 2 }; actionTbl[{14, "RPAREN"}] = { ACTION_REDUCE, 2 };
+    actionTbl[{14, "PLUS"}] = { ACTION_REDUCE, 2 }; actionTbl[{14, "#"}] = { ACTION_REDUCE, 2 }; actionTbl[{14, "RPAREN"}] = { ACTION_REDUCE, 2 };
     actionTbl[{14, "SEMI"}] = { ACTION_REDUCE, 2 };
+    actionTbl[{14, "MOD"}] = { ACTION_SHIFT, 31 };
     // State 15
     addReduce(15, 4);
 
@@ -233,7 +249,7 @@ void createMockParserTables(ActionTable& actionTbl, GotoTable& gotoTbl) {
     gotoTbl[{23, "S"}] = 24;
 
     // State 24: S 结束
-    actionTbl[{24, "EOF"}] = { ACTION_REDUCE, 11 };
+    actionTbl[{24, "#"}] = { ACTION_REDUCE, 11 };
     actionTbl[{24, "SEMI"}] = { ACTION_REDUCE, 11 }; // IF 语句也是一句 S，后面可能是分号
 
 
@@ -253,10 +269,19 @@ void createMockParserTables(ActionTable& actionTbl, GotoTable& gotoTbl) {
 
     // State 28: Seen "L ; M S". Reduce L -> L ; M S (Rule 13)
     // 后面可能还是分号，或者 EOF
-    actionTbl[{28, "EOF"}] = { ACTION_REDUCE, 13 };
+    actionTbl[{28, "#"}] = { ACTION_REDUCE, 13 };
     actionTbl[{28, "SEMI"}] = { ACTION_REDUCE, 13 };
 
-    actionTbl[{30, "EOF"}] = { ACTION_ACCEPT, 0 };
+    actionTbl[{30, "#"}] = { ACTION_ACCEPT, 0 };
+
+    // === 新增：取模 (States 31-32) ===
+
+    // State 31: Seen "T %". Expect F
+    actionTbl[{31, "NUM"}] = { ACTION_SHIFT, 7 }; actionTbl[{31, "ID"}] = { ACTION_SHIFT, 8 }; actionTbl[{31, "LPAREN"}] = { ACTION_SHIFT, 11 };
+    gotoTbl[{31, "F"}] = 32;
+
+    // State 32: Seen "T % F". Reduce T -> T MOD F (Rule 14)
+    addReduce(32, 14);
 }
 
 // ==========================================
@@ -284,12 +309,13 @@ int main() {
 
     std::cout << "\n=============================================" << std::endl;
     std::cout << "Test Case Plan:" << std::endl;
-    std::cout << "  Input:  a = 1 ; ? ( a < 10 ) b = 2" << std::endl;
+    std::cout << "  Input:  a=1;?(a<10)b=a%3" << std::endl;
     std::cout << "  Expect: " << std::endl;
     std::cout << "     0: a = 1" << std::endl;
     std::cout << "     1: if a < 10 goto 3" << std::endl;
     std::cout << "     2: goto (Next)" << std::endl;
-    std::cout << "     3: b = 2" << std::endl;
+    std::cout << "     3: t1 = a % 3" << std::endl;
+    std::cout << "     4: b = t1" << std::endl;
     std::cout << "=============================================" << std::endl;
 
     return 0;
@@ -0,0 +1,493 @@
+// GeneratorBench/main.cpp
+// 生成器规模基准：合成不同规模的词法规则与文法，分别计时 LexerGenerator / ParserGenerator
+// 的各个阶段以及 CodeEmitter，输出为固定列的 CSV，便于不同版本之间对比扩展曲线
+#include "CompilerGenerator/LexerGenerator.h"
+#include "CompilerGenerator/ParserGenerator.h"
+#include "CompilerGenerator/CodeEmitter.h"
+#include "CompilerGenerator/GeneratorStats.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+static const char* BENCH_OUTPUT_DIR = "bench_output";
+
+// ==========================================
+// 1. 合成输入
+// ==========================================
+
+struct BenchInput {
+    std::vector<TokenDefinition> tokens;
+    std::vector<ProductionRule> rules;
+};
+
+// 正则中的元字符全部转义，得到匹配字面串的模式
+static std::string literalPattern(const std::string& text) {
+    std::string pattern;
+    for (char c : text) {
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_')) {
+            pattern += '\\';
+        }
+        pattern += c;
+    }
+    return pattern;
+}
+
+static void addToken(BenchInput& input, const std::string& name, const std::string& pattern) {
+    TokenDefinition token;
+    token.name = name;
+    token.pattern = pattern;
+    input.tokens.push_back(token);
+}
+
+static void addRule(BenchInput& input, const std::string& lhs, const std::vector<std::string>& rhs) {
+    ProductionRule rule;
+    rule.id = (int)input.rules.size();
+    rule.lhs = lhs;
+    rule.rhs = rhs;
+    input.rules.push_back(rule);
+}
+
+// 第 index 个关键字：index 的 26 进制表示 (小写字母，至少 3 位)，互不相同
+static std::string keywordName(int index) {
+    std::string word;
+    int n = index;
+    while (n > 0 || word.size() < 3) {
+        word += (char)('a' + n % 26);
+        n /= 26;
+    }
+    return word;
+}
+
+// 第 index 个运算符：按长度枚举运算符字符的组合
+static std::string operatorText(int index) {
+    static const std::string chars = "+-*/<>=!&|^%~";
+    const int base = (int)chars.size();
+    int length = 1;
+    int count = base;
+    while (index >= count) {
+        index -= count;
+        ++length;
+        count *= base;
+    }
+    std::string text;
+    for (int i = 0; i < length; ++i) {
+        text += chars[index % base];
+        index /= base;
+    }
+    return text;
+}
+
+// 公共部分：标识符、数字与空白
+static void addCommonTokens(BenchInput& input) {
+    addToken(input, "NUM", "[0-9]+");
+    addToken(input, "ID", "[a-zA-Z_]+");
+    addToken(input, "SKIP", "[ \\t\\n\\r]+");
+}
+
+// 词法场景共用的最小文法
+static void addTrivialGrammar(BenchInput& input) {
+    addRule(input, "Program", { "Program", "Item" });
+    addRule(input, "Program", { "Item" });
+    addRule(input, "Item", { "ID" });
+    addRule(input, "Item", { "NUM" });
+}
+
+// N 个关键字 (都会与 ID 规则竞争)
+static BenchInput lexerKeywords(int n) {
+    BenchInput input;
+    for (int i = 0; i < n; ++i) {
+        addToken(input, "KW_" + std::to_string(i), keywordName(i));
+    }
+    addCommonTokens(input);
+    addTrivialGrammar(input);
+    return input;
+}
+
+// M 个由运算符字符组成的 (转义) 字面串，共享大量前缀
+static BenchInput lexerOperators(int m) {
+    BenchInput input;
+    for (int i = 0; i < m; ++i) {
+        addToken(input, "OP_" + std::to_string(i), literalPattern(operatorText(i)));
+    }
+    addCommonTokens(input);
+    addTrivialGrammar(input);
+    return input;
+}
+
+// 嵌套分组与字符类：class(d) = ([0-k] class(d-1) | [a-k])+，每条规则以不同的前缀字母开头
+static std::string nestedClass(int depth, int salt) {
+    std::string digits = std::string("[0-") + (char)('0' + salt % 10) + "]";
+    std::string letters = std::string("[a-") + (char)('a' + salt % 26) + "]";
+    if (depth == 0) return letters;
+    return "(" + digits + nestedClass(depth - 1, salt + 1) + "|" + letters + ")+";
+}
+
+static BenchInput lexerCharClasses(int k) {
+    BenchInput input;
+    for (int i = 0; i < k; ++i) {
+        std::string prefix = std::string(1, (char)('A' + i % 26)) + std::string(1, (char)('A' + (i / 26) % 26));
+        addToken(input, "CLS_" + std::to_string(i), prefix + nestedClass(2, i));
+    }
+    addCommonTokens(input);
+    addTrivialGrammar(input);
+    return input;
+}
+
+// 大字符类与重复次数：每条规则一个带前缀的字符串字面量 "[^"\n]*" 与一个 {1,8} 位的十六进制数
+// 按字节展开时每个 [^...] 有 250 多条转移，按区间只有几条
+static BenchInput lexerNegatedClasses(int k) {
+    BenchInput input;
+    for (int i = 0; i < k; ++i) {
+        std::string prefix = std::string(1, (char)('A' + i % 26)) + std::string(1, (char)('A' + (i / 26) % 26));
+        addToken(input, "STR_" + std::to_string(i), prefix + "\"[^\"\\n]*\"");
+        addToken(input, "HEX_" + std::to_string(i), prefix + "#[0-9a-f]{1,8}");
+    }
+    addCommonTokens(input);
+    addTrivialGrammar(input);
+    return input;
+}
+
+// 子集构造指数爆炸：倒数第 n 个字符为 a，完整 DFA 需要 2^n 个状态，超出状态上限后走惰性 DFA
+static BenchInput lexerBlowup(int n) {
+    BenchInput input;
+    std::string pattern = "@[ab]*a";
+    for (int i = 0; i < n; ++i) {
+        pattern += "[ab]";
+    }
+    addToken(input, "BLOWUP", pattern);
+    addCommonTokens(input);
+    addTrivialGrammar(input);
+    return input;
+}
+
+// 表达式优先级阶梯：E0 -> E0 op0 E1 | E1, ..., EL -> ( E0 ) | NUM | ID
+static BenchInput grammarExprLadder(int levels) {
+    BenchInput input;
+    for (int i = 0; i < levels; ++i) {
+        addToken(input, "OP_" + std::to_string(i), literalPattern(operatorText(i)));
+    }
+    addToken(input, "LPAREN", "\\(");
+    addToken(input, "RPAREN", "\\)");
+    addCommonTokens(input);
+
+    addRule(input, "Program", { "E0" });
+    for (int i = 0; i < levels; ++i) {
+        std::string lhs = "E" + std::to_string(i);
+        std::string next = "E" + std::to_string(i + 1);
+        addRule(input, lhs, { lhs, "OP_" + std::to_string(i), next });
+        addRule(input, lhs, { next });
+    }
+    std::string atom = "E" + std::to_string(levels);
+    addRule(input, atom, { "LPAREN", "E0", "RPAREN" });
+    addRule(input, atom, { "NUM" });
+    addRule(input, atom, { "ID" });
+    return input;
+}
+
+// 长语句表：S 种以不同关键字开头的语句
+static BenchInput grammarStmtList(int kinds) {
+    BenchInput input;
+    for (int i = 0; i < kinds; ++i) {
+        addToken(input, "KW_" + std::to_string(i), keywordName(i));
+    }
+    addToken(input, "ASSIGN", "=");
+    addToken(input, "PLUS", "\\+");
+    addToken(input, "SEMI", ";");
+    addCommonTokens(input);
+
+    addRule(input, "Program", { "StmtList" });
+    addRule(input, "StmtList", { "StmtList", "Stmt" });
+    addRule(input, "StmtList", { "Stmt" });
+    for (int i = 0; i < kinds; ++i) {
+        addRule(input, "Stmt", { "KW_" + std::to_string(i), "ID", "ASSIGN", "Expr", "SEMI" });
+    }
+    addRule(input, "Expr", { "Expr", "PLUS", "Term" });
+    addRule(input, "Expr", { "Term" });
+    addRule(input, "Term", { "NUM" });
+    addRule(input, "Term", { "ID" });
+    return input;
+}
+
+// 深层嵌套：每一层有自己的括号，Blk_i -> LB_i List_i RB_i，List_i -> List_i Blk_{i+1} | Blk_{i+1}
+static BenchInput grammarNesting(int depth) {
+    BenchInput input;
+    for (int i = 0; i < depth; ++i) {
+        addToken(input, "LB_" + std::to_string(i), literalPattern("{" + keywordName(i)));
+        addToken(input, "RB_" + std::to_string(i), literalPattern(keywordName(i) + "}"));
+    }
+    addToken(input, "SEMI", ";");
+    addCommonTokens(input);
+
+    addRule(input, "Program", { "Blk_0" });
+    for (int i = 0; i < depth; ++i) {
+        std::string index = std::to_string(i);
+        std::string inner = "Blk_" + std::to_string(i + 1);
+        addRule(input, "Blk_" + index, { "LB_" + index, "List_" + index, "RB_" + index });
+        addRule(input, "List_" + index, { "List_" + index, inner });
+        addRule(input, "List_" + index, { inner });
+    }
+    addRule(input, "Blk_" + std::to_string(depth), { "ID", "SEMI" });
+    return input;
+}
+
+// ==========================================
+// 2. 运行与计时
+// ==========================================
+
+struct Scenario {
+    const char* name;
+    BenchInput (*make)(int size);
+    std::vector<int> sizes;
+    std::vector<int> quickSizes;
+};
+
+// 词法分析器的 DFA 构造方法 (--construction)
+struct Construction {
+    const char* name;
+    LexerConstruction value;
+};
+
+static const Construction CONSTRUCTIONS[] = {
+    { "thompson", LEXER_THOMPSON },
+    { "followpos", LEXER_FOLLOWPOS },
+    { "derivatives", LEXER_DERIVATIVES },
+};
+
+// 内存只记录本次运行分配的总字节数：峰值 RSS 是进程级的高水位，前面的大场景会掩盖后面各行
+struct BenchResult {
+    std::string scenario;
+    std::string construction;
+    int size;
+    GeneratorStats stats;
+    double totalMs;
+    unsigned long long allocatedBytes;
+};
+
+// 丢弃生成器运行过程中的日志输出 (ParserGenerator 每条产生式都会打印一行)
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+static bool runOnce(const BenchInput& input, LexerConstruction construction, unsigned int threads, GeneratorStats& stats) {
+    LexerGenerator lexGen;
+    lexGen.setStats(&stats);
+    lexGen.setConstruction(construction);
+    lexGen.setThreads(threads);
+    for (const auto& token : input.tokens) {
+        lexGen.addRule(token.name, token.pattern);
+    }
+    {
+        StatsPhase phase(&stats, "lexer.build");
+        lexGen.build();
+    }
+
+    ParserGenerator parserGen;
+    parserGen.setStats(&stats);
+    parserGen.setStartSymbol(input.rules[0].lhs);
+    for (const auto& rule : input.rules) {
+        parserGen.addProduction(rule.lhs, rule.rhs, rule.semanticAction);
+    }
+    {
+        StatsPhase phase(&stats, "parser.build");
+        parserGen.build();
+    }
+
+    CodeEmitter emitter(BENCH_OUTPUT_DIR);
+    bool emitted;
+    {
+        StatsPhase phase(&stats, "emit.lexer");
+        emitted = lexGen.isLazyDFA() ? emitter.emitLazyLexer(lexGen.getCompactNFA(), lexGen.getKeywords())
+                                     : emitter.emitLexer(lexGen.getDFATable(), lexGen.getKeywords());
+    }
+    if (emitted) {
+        StatsPhase phase(&stats, "emit.parser");
+        emitted = emitter.emitParser(parserGen.getActionTable(), parserGen.getGotoTable(),
+                                     parserGen.getRules(), SymbolTypeMap());
+    }
+    stats.setCounter("emittedBytes", (long long)emitter.getEmittedBytes());
+    return emitted;
+}
+
+// 重复 repeat 次，保留总耗时最短的一次 (减少调度与缓存带来的噪声)
+static bool runScenario(const Scenario& scenario, const Construction& construction, unsigned int threads, int size, int repeat, BenchResult& best) {
+    BenchInput input = scenario.make(size);
+    bool haveResult = false;
+    for (int r = 0; r < repeat; ++r) {
+        BenchResult result;
+        result.scenario = scenario.name;
+        result.construction = construction.name;
+        result.size = size;
+
+        unsigned long long bytesBefore = GeneratorStats::allocatedBytes();
+        NullBuffer nullBuffer;
+        std::streambuf* saved = std::cout.rdbuf(&nullBuffer);
+        bool ok = runOnce(input, construction.value, threads, result.stats);
+        std::cout.rdbuf(saved);
+        if (!ok) return false;
+
+        result.allocatedBytes = GeneratorStats::allocatedBytes() - bytesBefore;
+        result.totalMs = result.stats.phaseMs("lexer.build") + result.stats.phaseMs("parser.build")
+                       + result.stats.phaseMs("emit.lexer") + result.stats.phaseMs("emit.parser");
+        if (!haveResult || result.totalMs < best.totalMs) {
+            best = std::move(result);
+            haveResult = true;
+        }
+    }
+    return haveResult;
+}
+
+// ==========================================
+// 3. 输出 (CSV)
+// ==========================================
+
+static const char* PHASE_COLUMNS[] = {
+    "lexer.nfa", "lexer.epsilon", "lexer.subset", "lexer.ast", "lexer.followpos", "lexer.derivative", "lexer.minimize", "lexer.lazy",
+    "parser.first", "parser.items", "parser.table",
+    "emit.lexer", "emit.parser",
+};
+
+static const char* COUNTER_COLUMNS[] = {
+    "lexRules", "grammarRules", "nfaStates", "epsilonFreeNfaStates", "positions", "derivativeTerms", "dfaStates", "minimizedDfaStates",
+    "lr1ItemSets", "closureCalls", "actionEntries", "gotoEntries", "emittedBytes", "lazyDfa", "keywords",
+};
+
+static void writeHeader(std::ostream& os) {
+    os << "scenario,construction,size";
+    for (const char* phase : PHASE_COLUMNS) os << "," << phase << "_ms";
+    os << ",total_ms,slope";
+    for (const char* counter : COUNTER_COLUMNS) os << "," << counter;
+    os << ",allocatedBytes" << std::endl;
+}
+
+// slope: 相对同一场景上一个规模的 log(时间比) / log(规模比)，近似增长阶数 (1 为线性，2 为平方)
+static void writeRow(std::ostream& os, const BenchResult& result, const BenchResult* previous) {
+    std::ios::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(3);
+    os << result.scenario << "," << result.construction << "," << result.size;
+    for (const char* phase : PHASE_COLUMNS) os << "," << result.stats.phaseMs(phase);
+    os << "," << result.totalMs << ",";
+    if (previous != nullptr && previous->totalMs > 0 && result.totalMs > 0) {
+        os << std::log(result.totalMs / previous->totalMs) / std::log((double)result.size / previous->size);
+    }
+    for (const char* counter : COUNTER_COLUMNS) os << "," << result.stats.counter(counter);
+    os << "," << result.allocatedBytes << std::endl;
+    os.flags(flags);
+}
+
+static void makeDirectory(const char* path) {
+#ifdef _WIN32
+    _mkdir(path);
+#else
+    mkdir(path, 0755);
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+    // 用法: GeneratorBench [--quick] [--repeat N] [--csv 文件] [--only 场景名] [--construction 名字|all] [--threads N]
+    //   --quick   每个场景只跑较小的两档规模
+    //   --repeat  每档规模重复次数，取总耗时最短的一次 (默认 3)
+    //   --csv     结果同时写入该文件 (默认 generator_bench.csv)
+    //   --only    只运行名字以该前缀开头的场景
+    //   --construction  DFA 构造方法 thompson / followpos / derivatives，all 为逐个运行 (默认 thompson)
+    //   --threads  Thompson NFA 与子集构造的线程数 (默认 1，0 为硬件线程数)
+    bool quick = false;
+    unsigned int threads = 1;
+    std::string constructionName = "thompson";
+    int repeat = 3;
+    std::string csvPath = "generator_bench.csv";
+    std::string only;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--quick") {
+            quick = true;
+        }
+        else if (arg == "--repeat" && i + 1 < argc) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--csv" && i + 1 < argc) {
+            csvPath = argv[++i];
+        }
+        else if (arg == "--only" && i + 1 < argc) {
+            only = argv[++i];
+        }
+        else if (arg == "--construction" && i + 1 < argc) {
+            constructionName = argv[++i];
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            threads = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+        }
+        else {
+            std::cerr << "[Warning] Unknown option " << arg << " ignored." << std::endl;
+        }
+    }
+
+    // 规模按 LR(1) 规范族构造的实际开销选取，最大一档在 Release 下为秒级
+    const Scenario scenarios[] = {
+        { "lexer-keywords",     lexerKeywords,     { 16, 64, 256, 1024 }, { 16, 64 } },
+        { "lexer-operators",    lexerOperators,    { 8, 32, 128, 512 },   { 8, 32 } },
+        { "lexer-charclasses",  lexerCharClasses,  { 4, 16, 64, 256 },    { 4, 16 } },
+        { "lexer-negated",      lexerNegatedClasses, { 4, 16, 64, 256 },  { 4, 16 } },
+        { "lexer-blowup",       lexerBlowup,       { 4, 8, 12, 16 },      { 4, 8 } },
+        { "grammar-expr-ladder", grammarExprLadder, { 2, 4, 8, 16 },      { 2, 4 } },
+        { "grammar-stmt-list",  grammarStmtList,   { 4, 8, 16, 32 },      { 4, 8 } },
+        { "grammar-nesting",    grammarNesting,    { 2, 4, 8, 16 },       { 2, 4 } },
+    };
+
+    std::vector<Construction> constructions;
+    for (const auto& construction : CONSTRUCTIONS) {
+        if (constructionName == "all" || constructionName == construction.name) constructions.push_back(construction);
+    }
+    if (constructions.empty()) {
+        std::cerr << "Error: Unknown construction " << constructionName << "." << std::endl;
+        return 1;
+    }
+
+    // 每行的 allocatedBytes 列与各阶段的分配统计来自全局分配计数
+    GeneratorStats::setAllocationCounting(true);
+    makeDirectory(BENCH_OUTPUT_DIR);
+
+    std::ofstream csv(csvPath);
+    if (!csv.is_open()) {
+        std::cerr << "Error: Could not open file " << csvPath << " for writing." << std::endl;
+        return 1;
+    }
+    writeHeader(std::cout);
+    writeHeader(csv);
+
+    for (const auto& scenario : scenarios) {
+        if (!only.empty() && std::string(scenario.name).compare(0, only.size(), only) != 0) continue;
+
+        for (const auto& construction : constructions) {
+            BenchResult previous;
+            bool havePrevious = false;
+            for (int size : quick ? scenario.quickSizes : scenario.sizes) {
+                BenchResult result;
+                if (!runScenario(scenario, construction, threads, size, repeat, result)) {
+                    std::cerr << "[Error] " << scenario.name << " size " << size << " failed to emit." << std::endl;
+                    return 1;
+                }
+                writeRow(std::cout, result, havePrevious ? &previous : nullptr);
+                writeRow(csv, result, havePrevious ? &previous : nullptr);
+                previous = std::move(result);
+                havePrevious = true;
+            }
+        }
+    }
+
+    std::cerr << "-> Results written to " << csvPath << std::endl;
+    return 0;
+}
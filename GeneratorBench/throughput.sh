@@ -0,0 +1,128 @@
+#!/bin/bash
+# 生成的编译器的运行时吞吐量测试
+# 对 rules.txt / rules2.txt 分别生成编译器，在每种生成模式下用同一批 1KB ~ 64MB 的输入测试，
+# 输出 CSV：词法 tokens/s、归约/s、端到端 MB/s、峰值内存与运行状态
+#
+# 用法: GeneratorBench/throughput.sh [模式...]
+#   模式: default (默认)、pipeline (--pipeline)、shards (--shards 4)
+# 环境变量:
+#   SIZES   输入规模列表，默认 "1K 64K 1M 16M 64M"
+#           解析会保留全部中间代码与语义值，峰值内存约为输入文件的 15 倍 (输入由翻倍得到，最多比标称大小大一倍；
+#           64M 不到 2 GB)；256M、1G 需要相应的内存
+#   RULES   规则文件列表，默认 "rules.txt rules2.txt"
+#   INPUTS  输入来源：seed (默认，整份重复种子程序) 或 random (生成器 --sentences 按文法随机生成)
+#   WORK    工作目录，默认 ./throughput_work
+#   CXX / CXXFLAGS  编译器与编译选项，默认 g++ / -O2
+set -e
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+SIZES=${SIZES:-"1K 64K 1M 16M 64M"}
+RULES=${RULES:-"rules.txt rules2.txt"}
+INPUTS=${INPUTS:-seed}
+WORK=${WORK:-$PWD/throughput_work}
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--O2}
+MODES=${*:-default}
+
+mkdir -p "$WORK"
+RESULT="$WORK/throughput.csv"
+
+# 每种语言的种子程序；输入由种子整份重复得到，保证语法正确
+seed_program() {
+    case "$1" in
+    rules.txt)
+        cat <<'EOF'
+x = 1;
+while (x < 10 && y > 2 || x == 3) { x = x + 1; if (x > 5) print(x); else y = y * (2 + x); }
+print(y);
+EOF
+        ;;
+    rules2.txt)
+        cat <<'EOF'
+func f(a) { return a; }
+func g(x) { y = f(x); z = f(3); return z; }
+EOF
+        ;;
+    *)
+        echo "No seed program for $1" >&2
+        return 1
+        ;;
+    esac
+}
+
+# 1K / 64K / 1M / 1G -> 字节数
+size_bytes() {
+    local n=${1%[KMG]}
+    case "$1" in
+    *K) echo $((n * 1024)) ;;
+    *M) echo $((n * 1024 * 1024)) ;;
+    *G) echo $((n * 1024 * 1024 * 1024)) ;;
+    *) echo "$n" ;;
+    esac
+}
+
+mode_flags() {
+    case "$1" in
+    default) echo "" ;;
+    pipeline) echo "--pipeline" ;;
+    shards) echo "--shards 4" ;;
+    *) echo "Unknown mode $1" >&2; return 1 ;;
+    esac
+}
+
+# 不断把文件翻倍直到不小于目标大小 (实际大小记录在结果中)
+make_input() {
+    local seed=$1 target=$2 out=$3
+    cp "$seed" "$out"
+    while [ "$(stat -c %s "$out")" -lt "$target" ]; do
+        cat "$out" "$out" > "$out.tmp"
+        mv "$out.tmp" "$out"
+    done
+}
+
+echo "[Build] Generator"
+$CXX -std=c++14 -O2 -o "$WORK/generator" $(ls "$ROOT"/CompilerGenerator/*.cpp)
+
+echo "rules,mode,size,bytes,tokens,lex_s,tokens_per_s,shifts,reductions,parse_s,reductions_per_s,mb_per_s,peak_rss_kb,accepted,status" > "$RESULT"
+
+for rules in $RULES; do
+    inputs="$WORK/inputs/${rules%.txt}-$INPUTS"
+    mkdir -p "$inputs/output"
+    [ "$INPUTS" = random ] || seed_program "$rules" > "$inputs/seed.txt"
+    for size in $SIZES; do
+        [ -f "$inputs/$size.txt" ] && continue
+        if [ "$INPUTS" = random ]; then
+            (cd "$inputs" && "$WORK/generator" "$ROOT/CompilerGenerator/$rules" --sentences "$size" "$size.txt" > sentences.log)
+        else
+            make_input "$inputs/seed.txt" "$(size_bytes "$size")" "$inputs/$size.txt"
+        fi
+    done
+
+    for mode in $MODES; do
+        dir="$WORK/${rules%.txt}-$mode"
+        rm -rf "$dir"
+        mkdir -p "$dir/output"
+        echo "[Build] $rules ($mode)"
+        (cd "$dir" && "$WORK/generator" "$ROOT/CompilerGenerator/$rules" $(mode_flags "$mode") > generator.log)
+        $CXX -std=c++17 $CXXFLAGS -pthread -I"$dir/output" -o "$dir/throughput" \
+            $(ls "$dir"/output/*.cpp | grep -v batch_main) "$ROOT/GeneratorBench/throughput_main.cpp"
+
+        # status: ok / rejected (输入未被接受，数据仍有效) / exit N / signal N (崩溃或被杀，例如内存不足)
+        for size in $SIZES; do
+            code=0
+            line=$("$dir/throughput" "$inputs/$size.txt") || code=$?
+            if [ $code -eq 0 ]; then
+                status=ok
+            elif [ $code -eq 1 ] && [ -n "$line" ]; then
+                status=rejected
+            else
+                if [ $code -gt 128 ]; then status="signal $((code - 128))"; else status="exit $code"; fi
+                echo "[Error] $rules ($mode) $size: $status" >&2
+                line=",,,,,,,,,,"
+            fi
+            echo "$rules,$mode,$size,$line,$status" | tee -a "$RESULT"
+        done
+    done
+done
+
+echo "-> Results written to $RESULT"
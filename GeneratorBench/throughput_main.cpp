@@ -0,0 +1,111 @@
+// GeneratorBench/throughput_main.cpp
+// 生成的编译器的运行时吞吐量测试驱动 (由 throughput.sh 与 output/ 下生成的 lexer.cpp / parser.cpp 一起编译，
+// 不属于 GeneratorBench 工程)
+// 对同一份输入先只做词法分析，再完整解析一遍，输出一行 CSV：
+//   bytes,tokens,lex_s,tokens_per_s,shifts,reductions,parse_s,reductions_per_s,mb_per_s,peak_rss_kb,accepted
+#include "lexer.h"
+#include "parser.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+static long long peakRssKB() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        return (long long)(pmc.PeakWorkingSetSize / 1024);
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return (long long)(usage.ru_maxrss / 1024);
+#else
+    return (long long)usage.ru_maxrss;
+#endif
+#endif
+}
+
+static bool readFile(const std::string& path, std::string& content) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    file.seekg(0, std::ios::end);
+    content.resize((size_t)file.tellg());
+    file.seekg(0, std::ios::beg);
+    file.read(&content[0], (std::streamsize)content.size());
+    return (bool)file;
+}
+
+// 丢弃解析器输出的中间代码 (仍然会完整地格式化一遍)
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+    // 用法: throughput_main 输入文件 [--header]
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <input file> [--header]" << std::endl;
+        return 2;
+    }
+    if (argc > 2 && std::string(argv[2]) == "--header") {
+        std::cout << "bytes,tokens,lex_s,tokens_per_s,shifts,reductions,parse_s,reductions_per_s,mb_per_s,peak_rss_kb,accepted" << std::endl;
+    }
+
+    std::string source;
+    if (!readFile(argv[1], source)) {
+        std::cerr << "Error: Could not read " << argv[1] << std::endl;
+        return 2;
+    }
+
+    // 1. 只做词法分析
+    Lexer lexer(source);
+    unsigned long long tokens = 0;
+    auto lexStart = std::chrono::steady_clock::now();
+    while (lexer.nextToken().type != "#") {
+        tokens++;
+    }
+    double lexSeconds = secondsSince(lexStart);
+
+    // 2. 端到端：词法 + 语法分析 + 语义动作 + 输出中间代码
+    NullBuffer nullBuffer;
+    std::ostream nullStream(&nullBuffer);
+    lexer.reset(source);
+    Parser parser(lexer);
+    parser.setOutputStreams(nullStream, std::cerr);
+    auto parseStart = std::chrono::steady_clock::now();
+    bool accepted = parser.parse();
+    double parseSeconds = secondsSince(parseStart);
+
+    double megabytes = source.size() / (1024.0 * 1024.0);
+    std::cout << std::fixed << std::setprecision(6)
+              << source.size() << ","
+              << tokens << ","
+              << lexSeconds << ","
+              << std::setprecision(0) << (lexSeconds > 0 ? tokens / lexSeconds : 0) << ","
+              << parser.getShiftCount() << ","
+              << parser.getReductionCount() << ","
+              << std::setprecision(6) << parseSeconds << ","
+              << std::setprecision(0) << (parseSeconds > 0 ? parser.getReductionCount() / parseSeconds : 0) << ","
+              << std::setprecision(3) << (parseSeconds > 0 ? megabytes / parseSeconds : 0) << ","
+              << peakRssKB() << ","
+              << (accepted ? 1 : 0) << std::endl;
+    return accepted ? 0 : 1;
+}